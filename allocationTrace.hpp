@@ -0,0 +1,167 @@
+/** @file allocationTrace.hpp
+ *  @brief Binary traces of the allocations of a pool
+ *
+ *  A trace is a TraceHeader followed by one TraceRecord per allocate or
+ *  deallocate, in the byte order of the machine that wrote it. Pools record
+ *  their traces when POOL_TRACE_ENABLED is defined (see
+ *  PoolAllocator::start_trace), and benchmarks/bench_replay.cpp replays them
+ *  against other pool configurations
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef allocationTrace_hpp
+#define allocationTrace_hpp
+
+#include "util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace _fmmAllocator {
+
+enum class TraceOp : std::uint32_t {
+  Allocate = 0,
+  Deallocate = 1,
+};
+
+/// @brief Start of every trace file
+struct TraceHeader {
+  char magic[8] = {'F', 'M', 'M', 'T', 'R', 'A', 'C', 'E'};
+  std::uint32_t version = 1;
+  /// sizeof of the elements of the pool
+  std::uint32_t element_size = 0;
+  /// Configuration of the recording pool
+  std::uint64_t block_size = 0;
+  std::uint32_t recycle_slots = 0;
+  std::uint32_t size_classes = 0;
+
+  bool valid() const {
+    return std::memcmp(magic, TraceHeader().magic, sizeof(magic)) == 0 &&
+           version == TraceHeader().version;
+  }
+};
+
+/// @brief One allocate or deallocate of \ref count elements
+struct TraceRecord {
+  /// Nanoseconds since the trace started
+  std::uint64_t time;
+  /// Identifies the allocation (its address): a deallocate refers to the
+  /// latest allocate of the same object
+  std::uint64_t object;
+  std::uint32_t count;
+  TraceOp op;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord is not packed");
+
+namespace detail {
+
+/// @brief Buffered writer of a trace file
+/// NOTE: Thread-safe, since a pool records the frees of other threads too
+class TraceWriter {
+public:
+  TraceWriter() = default;
+
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  ~TraceWriter() { close(); }
+
+  /// @brief Starts a new trace in \ref __path. Returns false if the file could
+  /// not be opened
+  bool open(const char *__path, const TraceHeader &__header) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ = std::fopen(__path, "wb");
+    if (file_ == nullptr) {
+      return false;
+    }
+    std::fwrite(&__header, sizeof(__header), 1, file_);
+    buffer_.reserve(buffered);
+    start_ = std::chrono::steady_clock::now();
+    open_.store(true, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Flushes and closes the trace file, if any
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ != nullptr) {
+      open_.store(false, std::memory_order_relaxed);
+      flush();
+      std::fclose(file_);
+      file_ = nullptr;
+    }
+  }
+
+  bool is_open() const { return open_.load(std::memory_order_relaxed); }
+
+  void record(TraceOp __op, const void *__object, std::size_t __count) {
+    // Not recording: no lock taken
+    if (likely(!is_open())) {
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) {
+      return;
+    }
+    buffer_.push_back(TraceRecord{
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_)
+                .count()),
+        reinterpret_cast<std::uintptr_t>(__object),
+        static_cast<std::uint32_t>(__count), __op});
+    if (buffer_.size() == buffered) {
+      flush();
+    }
+  }
+
+private:
+  void flush() {
+    std::fwrite(buffer_.data(), sizeof(TraceRecord), buffer_.size(), file_);
+    buffer_.clear();
+  }
+
+  /// Records written at once
+  static constexpr std::size_t buffered = 4096;
+
+  std::atomic<bool> open_{false};
+  std::mutex mutex_;
+  std::FILE *file_ = nullptr;
+  std::vector<TraceRecord> buffer_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace detail
+
+/// @brief Reads a whole trace file. Returns false if it could not be read or
+/// is not a trace
+inline bool read_trace(const char *__path, TraceHeader &__header,
+                       std::vector<TraceRecord> &__records) {
+  std::FILE *file = std::fopen(__path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool ok = std::fread(&__header, sizeof(__header), 1, file) == 1 &&
+            __header.valid();
+
+  __records.clear();
+  TraceRecord record;
+  while (ok && std::fread(&record, sizeof(record), 1, file) == 1) {
+    __records.push_back(record);
+  }
+  std::fclose(file);
+  return ok;
+}
+
+} // namespace _fmmAllocator
+#endif /* allocationTrace_hpp */
@@ -0,0 +1,99 @@
+//
+//  bench_bulk.cpp
+//  memorypool
+//
+//  Building and tearing down a linked container of nodes with one allocate
+//  and one deallocate per node, against allocate_bulk and deallocate_bulk
+//  Usage: bench_bulk [nodes]
+//
+
+#include "bench_util.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+
+struct Node {
+  Node *next;
+  std::uint64_t value;
+};
+
+/// Links \ref nodes into a list, in their order
+Node *link(std::vector<Node *> &nodes) {
+  Node *head = nullptr;
+  for (std::size_t i = nodes.size(); i-- > 0;) {
+    nodes[i]->next = head;
+    nodes[i]->value = i;
+    head = nodes[i];
+  }
+  return head;
+}
+
+/// Builds and tears down a container of \ref n_nodes, visiting the nodes in
+/// \ref order when tearing it down
+template <bool _Recycle_Slots, bool _Bulk>
+double build_and_teardown(std::size_t n_nodes,
+                          const std::vector<std::size_t> &order) {
+  PoolAllocator<Node, BlockSize, _Recycle_Slots> allocator;
+  std::vector<Node *> nodes(n_nodes);
+  std::vector<Node *> teardown(n_nodes);
+
+  return time_best_of(5, [&]() {
+    // build
+    if (_Bulk) {
+      allocator.allocate_bulk(nodes.data(), n_nodes);
+    } else {
+      for (auto &node : nodes) {
+        node = allocator.allocate(1);
+      }
+    }
+    Node *head = link(nodes);
+
+    // teardown
+    for (std::size_t i = 0; i < n_nodes; ++i) {
+      teardown[i] = nodes[order[i]];
+    }
+    if (_Bulk) {
+      allocator.deallocate_bulk(teardown.data(), n_nodes);
+    } else {
+      for (auto node : teardown) {
+        allocator.deallocate(node, 1);
+      }
+    }
+    if (head == nullptr) {
+      std::printf("empty\n");
+    }
+  });
+}
+
+template <bool _Recycle_Slots>
+void compare(const char *name, std::size_t n_nodes,
+             const std::vector<std::size_t> &order) {
+  std::printf("%s\n", name);
+  const double single =
+      build_and_teardown<_Recycle_Slots, false>(n_nodes, order);
+  report("allocate / deallocate", single, single);
+  report("allocate_bulk / deallocate_bulk",
+         build_and_teardown<_Recycle_Slots, true>(n_nodes, order), single);
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_nodes =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::size_t(1) << 20;
+
+  std::vector<std::size_t> in_order(n_nodes);
+  for (std::size_t i = 0; i < n_nodes; ++i) {
+    in_order[i] = i;
+  }
+  std::vector<std::size_t> shuffled = in_order;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{});
+
+  std::printf("%zu nodes\n", n_nodes);
+  compare<false>("teardown in order, pool", n_nodes, in_order);
+  compare<true>("teardown in order, pool + recycle", n_nodes, in_order);
+  compare<false>("teardown shuffled, pool", n_nodes, shuffled);
+  compare<true>("teardown shuffled, pool + recycle", n_nodes, shuffled);
+  return 0;
+}
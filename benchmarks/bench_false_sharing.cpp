@@ -0,0 +1,81 @@
+//
+//  bench_false_sharing.cpp
+//  memorypool
+//
+//  Per-thread counters allocated one after the other from the same pool, then
+//  bumped by their threads: packed slots put several counters on a cache
+//  line, slots padded to cache lines (_Slot_Align) give each one its own
+//  Usage: bench_false_sharing [max_threads]
+//
+
+#include "bench_util.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+
+struct Counter {
+  std::atomic<std::uint64_t> value{0};
+};
+
+using PackedAllocator = PoolAllocator<Counter, BlockSize>;
+using PaddedAllocator =
+    PoolAllocator<Counter, BlockSize, false, detail::size_classes(BlockSize),
+                  HeapBlockSource, FixedGrowth, detail::cache_line>;
+
+/// Each thread increments a counter of its own
+template <typename _Allocator>
+double throughput(_Allocator &allocator, std::size_t n_threads) {
+  const std::size_t increments = 1 << 22;
+
+  std::vector<Counter *> counters;
+  for (std::size_t i = 0; i < n_threads; ++i) {
+    counters.push_back(new (allocator.allocate(1)) Counter());
+  }
+
+  const double seconds = time_best_of(3, [&]() {
+    std::vector<std::thread> threads;
+    for (Counter *counter : counters) {
+      threads.emplace_back([counter]() {
+        // A plain load and store: only the cache line is contended
+        for (std::size_t i = 0; i < increments; ++i) {
+          counter->value.store(
+              counter->value.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  });
+
+  for (Counter *counter : counters) {
+    counter->~Counter();
+    allocator.deallocate(counter, 1);
+  }
+  return static_cast<double>(increments * n_threads) / seconds;
+}
+
+int main(int argc, char **argv) {
+  const std::size_t max_threads =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+               : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+  std::printf("%8s %20s %20s %8s\n", "threads", "packed (Mops/s)",
+              "padded (Mops/s)", "speedup");
+  for (std::size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    PackedAllocator packed;
+    PaddedAllocator padded;
+
+    const double packed_ops = throughput(packed, n_threads);
+    const double padded_ops = throughput(padded, n_threads);
+    std::printf("%8zu %20.2f %20.2f %7.2fx\n", n_threads, packed_ops * 1e-6,
+                padded_ops * 1e-6, padded_ops / packed_ops);
+  }
+  return 0;
+}
@@ -0,0 +1,111 @@
+//
+//  bench_fork_join.cpp
+//  memorypool
+//
+//  Recursive fork/join fibonacci on the work-stealing ThreadPool against a
+//  pool of workers fed by a single ThreadSafeQueue
+//
+
+#include "../threadPool.hpp"
+#include "bench_util.hpp"
+
+#include <cstdlib>
+#include <functional>
+
+/// The baseline: every worker pops from one shared mutex-based queue
+class QueueThreadPool {
+public:
+  explicit QueueThreadPool(std::size_t n_threads) {
+    for (std::size_t i = 0; i < n_threads; ++i) {
+      threads_.emplace_back([this]() {
+        for (std::size_t idle = 0; !stop_.load(std::memory_order_acquire);) {
+          idle = run_one() ? 0 : idle + 1;
+          if (idle > 64) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+  }
+
+  ~QueueThreadPool() {
+    stop_.store(true, std::memory_order_release);
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  template <typename _Function> void submit(_Function &&func) {
+    tasks_.push_back(std::function<void()>(std::forward<_Function>(func)));
+  }
+
+  template <typename _Predicate> void run_until(_Predicate &&done) {
+    while (!done()) {
+      if (!run_one()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  bool run_one() {
+    std::function<void()> task;
+    if (!tasks_.try_pop(task)) {
+      return false;
+    }
+    task();
+    return true;
+  }
+
+  ThreadSafeQueue<std::function<void()>> tasks_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> stop_{false};
+};
+
+/// Forks both recursive calls and helps until they joined
+template <typename _Pool> long fib(_Pool &pool, long n, long cutoff) {
+  if (n < cutoff) {
+    return n < 2 ? n : fib(pool, n - 1, cutoff) + fib(pool, n - 2, cutoff);
+  }
+  long a = 0, b = 0;
+  std::atomic<int> done{0};
+  pool.submit([&]() {
+    a = fib(pool, n - 1, cutoff);
+    done.fetch_add(1, std::memory_order_release);
+  });
+  pool.submit([&]() {
+    b = fib(pool, n - 2, cutoff);
+    done.fetch_add(1, std::memory_order_release);
+  });
+  pool.run_until([&]() { return done.load(std::memory_order_acquire) == 2; });
+  return a + b;
+}
+
+/// Usage: bench_fork_join [n_threads] [n] [cutoff]
+int main(int argc, char **argv) {
+  const std::size_t n_threads =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+               : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  const long n = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 30;
+  const long cutoff = argc > 3 ? std::strtol(argv[3], nullptr, 10) : 12;
+
+  std::printf("fib(%ld), cutoff %ld, %zu threads\n", n, cutoff, n_threads);
+
+  long expected = 0, result = 0;
+  const double queue = time_best_of(3, [&]() {
+    QueueThreadPool pool(n_threads);
+    expected = fib(pool, n, cutoff);
+  });
+  const double stealing = time_best_of(3, [&]() {
+    ThreadPool pool(n_threads);
+    result = fib(pool, n, cutoff);
+  });
+  if (result != expected) {
+    std::printf("wrong result: %ld != %ld\n", result, expected);
+    return 1;
+  }
+
+  report("ThreadSafeQueue pool", queue, queue);
+  report("work-stealing pool", stealing, queue);
+  return 0;
+}
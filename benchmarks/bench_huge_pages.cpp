@@ -0,0 +1,174 @@
+//
+//  bench_huge_pages.cpp
+//  memorypool
+//
+//  Random reads over a large PoolAllocator<double, 2 MiB> for each block
+//  source: time to map and first touch the pool, time per random read and
+//  data TLB misses per read (where perf events are available)
+//
+
+#include "bench_util.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const std::size_t BlockSize = 2 * detail::MiB;
+using ScalarType = double;
+
+/// Counts the data TLB read misses of the calling thread (-1 if unavailable)
+class TlbMissCounter {
+public:
+  TlbMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  ~TlbMissCounter() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  void start() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  long long stop() {
+    long long count = -1;
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+      }
+    }
+#endif
+    return count;
+  }
+
+private:
+  int fd_ = -1;
+};
+
+struct Result {
+  double fill;
+  double access;
+  long long misses;
+};
+
+/// Fills \ref n_bytes of blocks, then reads \ref n_reads random elements
+template <class _Block_Source>
+Result random_access(std::size_t n_bytes, std::size_t n_reads) {
+  using Allocator = PoolAllocator<ScalarType, BlockSize, false,
+                                  detail::size_classes(BlockSize),
+                                  _Block_Source>;
+  const std::size_t count = Allocator::max_count();
+  const std::size_t n_chunks = n_bytes / BlockSize;
+
+  Result result;
+  Allocator allocator;
+  std::vector<ScalarType *> chunks;
+
+  // Mapping and first touch (page faults)
+  result.fill = time_best_of(1, [&]() {
+    for (std::size_t i = 0; i < n_chunks; ++i) {
+      chunks.push_back(allocator.allocate(count));
+      for (std::size_t j = 0; j < count; ++j) {
+        chunks.back()[j] = static_cast<ScalarType>(j);
+      }
+    }
+  });
+
+  TlbMissCounter counter;
+  ScalarType sum = 0.;
+  result.access = time_best_of(3, [&]() {
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+    counter.start();
+    for (std::size_t i = 0; i < n_reads; ++i) {
+      // xorshift64
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      sum += chunks[state % n_chunks][(state >> 32) % count];
+    }
+    result.misses = counter.stop();
+  });
+
+  for (auto chunk : chunks) {
+    allocator.deallocate(chunk, count);
+  }
+  if (sum < 0.) {
+    std::printf("%f\n", sum);
+  }
+  return result;
+}
+
+void report(const char *name, const Result &result, const Result &baseline,
+            std::size_t n_reads) {
+  std::printf("%-26s fill %9.2f ms %6.2fx   read %6.2f ns %6.2fx", name,
+              result.fill * 1e3, baseline.fill / result.fill,
+              result.access * 1e9 / n_reads, baseline.access / result.access);
+  if (result.misses >= 0) {
+    std::printf("   dTLB misses/read %.3f",
+                static_cast<double>(result.misses) / n_reads);
+  } else {
+    std::printf("   dTLB misses/read n/a");
+  }
+  std::printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  // Size of the pool in MiB and number of random reads
+  const std::size_t n_bytes =
+      (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024) * detail::MiB;
+  const std::size_t n_reads =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::size_t(1) << 24;
+
+  std::printf("random reads over %zu MiB of 2 MiB blocks\n",
+              n_bytes / detail::MiB);
+
+  const Result heap = random_access<HeapBlockSource>(n_bytes, n_reads);
+  report("operator new", heap, heap, n_reads);
+  report("mmap",
+         random_access<MmapBlockSource<HugePages::None>>(n_bytes, n_reads),
+         heap, n_reads);
+  report("mmap + THP",
+         random_access<MmapBlockSource<HugePages::Transparent>>(n_bytes,
+                                                                n_reads),
+         heap, n_reads);
+  report("mmap + THP, prefaulted",
+         random_access<MmapBlockSource<HugePages::Transparent, true>>(
+             n_bytes, n_reads),
+         heap, n_reads);
+  report("mmap + MAP_HUGETLB",
+         random_access<MmapBlockSource<HugePages::Explicit>>(n_bytes, n_reads),
+         heap, n_reads);
+
+  return 0;
+}
@@ -0,0 +1,369 @@
+//
+//  bench_latency.cpp
+//  memorypool
+//
+//  Latency of every single allocate and deallocate call of the PoolAllocator
+//  (with and without recycling) over a few workloads, recorded in log-linear
+//  (HDR-style) histograms: p50, p99, p99.9 and max per operation. The calls
+//  slower than the p99 are attributed to what the pool did meanwhile (see
+//  POOL_EVENT in util.hpp): getting or releasing a block, recycling, a long
+//  first-fit scan or a large mapping.
+//  Usage: bench_latency [scale]
+//
+
+#include <cstddef>
+#include <cstdint>
+
+/// Slow paths taken by the pools so far
+struct PoolEvents {
+  std::size_t new_block = 0;
+  std::size_t release_block = 0;
+  std::size_t large_map = 0;
+  std::size_t large_unmap = 0;
+  std::size_t scan = 0;
+  std::size_t remote_drain = 0;
+  std::size_t recycle = 0;
+};
+
+PoolEvents pool_events;
+
+#define POOL_EVENT(name, n) pool_events.name += static_cast<std::size_t>(n);
+
+#include "bench_util.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+const std::size_t BlockSize = 32 * detail::KiB;
+using ScalarType = double;
+
+/// A first-fit scan visiting at least that many chunks counts as long
+const std::size_t long_scan = 16;
+
+/// Scales the number of operations of every workload
+std::size_t scale = 1;
+
+/// Cheapest timestamp available: the TSC on x86, else steady_clock (ns)
+inline std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_lfence();
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+/// Nanoseconds per tick, measured against steady_clock
+double ns_per_tick() {
+  const auto start = std::chrono::steady_clock::now();
+  const std::uint64_t first = ticks();
+  while (std::chrono::steady_clock::now() - start <
+         std::chrono::milliseconds(20)) {
+  }
+  const std::uint64_t last = ticks();
+  const double elapsed = std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return elapsed / static_cast<double>(last - first);
+}
+
+/// @brief Log-linear histogram: values below 2^(sub_bits + 1) are exact, the
+/// others fall in one of 2^sub_bits buckets per power of two (a relative error
+/// of at most 2^-sub_bits)
+class LatencyHistogram {
+public:
+  void record(std::uint64_t value) {
+    ++counts_[bucket(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+  }
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t max() const { return max_; }
+
+  /// @brief Upper bound of the value at percentile \ref p (in [0, 100])
+  std::uint64_t percentile(double p) const {
+    const std::uint64_t rank = static_cast<std::uint64_t>(
+        std::ceil(p / 100. * static_cast<double>(count_)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < n_buckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank && seen > 0) {
+        return std::min(lowest(i + 1) - 1, max_);
+      }
+    }
+    return max_;
+  }
+
+  /// @brief Number of values in a bucket above the one of \ref value
+  std::uint64_t count_above(std::uint64_t value) const {
+    std::uint64_t count = 0;
+    for (std::size_t i = bucket(value) + 1; i < n_buckets; ++i) {
+      count += counts_[i];
+    }
+    return count;
+  }
+
+private:
+  static constexpr std::size_t sub_bits = 5;
+  static constexpr std::size_t sub_buckets = std::size_t(1) << sub_bits;
+  static constexpr std::size_t n_buckets = (64 - sub_bits + 1) * sub_buckets;
+
+  static std::size_t bucket(std::uint64_t value) {
+    if (value < 2 * sub_buckets) {
+      return static_cast<std::size_t>(value);
+    }
+    const std::size_t shift = detail::log2_floor(value) - sub_bits;
+    return (shift + 1) * sub_buckets +
+           static_cast<std::size_t>(value >> shift) - sub_buckets;
+  }
+
+  /// @brief Lowest value of the bucket \ref index
+  static std::uint64_t lowest(std::size_t index) {
+    if (index < 2 * sub_buckets) {
+      return index;
+    }
+    const std::size_t shift = index / sub_buckets - 1;
+    return std::uint64_t(index % sub_buckets + sub_buckets) << shift;
+  }
+
+  std::uint64_t counts_[n_buckets] = {};
+  std::uint64_t count_ = 0;
+  std::uint64_t max_ = 0;
+};
+
+/// @brief What made a call slow
+enum Cause { Block, Release, Recycle, Scan, Large, Remote, Other, n_causes };
+
+const char *cause_names[n_causes] = {"block", "release", "recycle", "scan",
+                                     "large", "remote", "other"};
+
+/// @brief The costliest slow path taken between two snapshots of the events
+Cause cause(const PoolEvents &before, const PoolEvents &after) {
+  if (after.recycle != before.recycle) {
+    return Recycle;
+  }
+  if (after.new_block != before.new_block) {
+    return Block;
+  }
+  if (after.release_block != before.release_block) {
+    return Release;
+  }
+  if (after.large_map != before.large_map ||
+      after.large_unmap != before.large_unmap) {
+    return Large;
+  }
+  if (after.scan - before.scan >= long_scan) {
+    return Scan;
+  }
+  if (after.remote_drain != before.remote_drain) {
+    return Remote;
+  }
+  return Other;
+}
+
+/// @brief Latencies (in ticks) of one operation, overall and per cause
+struct Recorder {
+  /// Times a single call of \ref op
+  template <typename _Operation> void time(_Operation &&op) {
+    const PoolEvents before = pool_events;
+    const std::uint64_t start = ticks();
+    op();
+    const std::uint64_t stop = ticks();
+    const std::uint64_t elapsed = stop - start;
+    all.record(elapsed);
+    by_cause[cause(before, pool_events)].record(elapsed);
+  }
+
+  LatencyHistogram all;
+  LatencyHistogram by_cause[n_causes];
+};
+
+std::string format_ns(double ns) {
+  char text[32];
+  if (ns < 1e3) {
+    std::snprintf(text, sizeof(text), "%5.0f ns", ns);
+  } else if (ns < 1e6) {
+    std::snprintf(text, sizeof(text), "%5.1f us", ns / 1e3);
+  } else {
+    std::snprintf(text, sizeof(text), "%5.1f ms", ns / 1e6);
+  }
+  return text;
+}
+
+void report(const char *operation, const Recorder &recorder, double ns) {
+  const LatencyHistogram &all = recorder.all;
+  const std::uint64_t p99 = all.percentile(99.);
+  std::printf("  %-10s %9llu calls  p50 %s  p99 %s  p99.9 %s  max %s\n",
+              operation, static_cast<unsigned long long>(all.count()),
+              format_ns(all.percentile(50.) * ns).c_str(),
+              format_ns(p99 * ns).c_str(),
+              format_ns(all.percentile(99.9) * ns).c_str(),
+              format_ns(all.max() * ns).c_str());
+
+  std::printf("  %-10s %9llu slower than p99:", "",
+              static_cast<unsigned long long>(all.count_above(p99)));
+  for (std::size_t i = 0; i < n_causes; ++i) {
+    const std::uint64_t slow = recorder.by_cause[i].count_above(p99);
+    if (slow > 0) {
+      std::printf("  %s %llu (max %s)", cause_names[i],
+                  static_cast<unsigned long long>(slow),
+                  format_ns(recorder.by_cause[i].max() * ns).c_str());
+    }
+  }
+  std::printf("\n");
+}
+
+/// Random order churn of single slots on a warm pool
+template <typename _Allocator>
+void single_slots(_Allocator &allocator, Recorder &allocs, Recorder &frees) {
+  const std::size_t n_live = std::size_t(1) << 14;
+  std::vector<ScalarType *> ptrs(n_live);
+  for (auto &ptr : ptrs) {
+    ptr = allocator.allocate(1);
+  }
+  std::mt19937 generator{};
+  std::uniform_int_distribution<std::size_t> pick(0, n_live - 1);
+  for (std::size_t i = 0; i < scale * (std::size_t(1) << 20); ++i) {
+    ScalarType *&ptr = ptrs[pick(generator)];
+    frees.time([&]() { allocator.deallocate(ptr, 1); });
+    allocs.time([&]() { ptr = allocator.allocate(1); });
+  }
+  for (auto ptr : ptrs) {
+    allocator.deallocate(ptr, 1);
+  }
+}
+
+/// Fills the pool with small chunks and frees all of them in random order,
+/// keeping no empty block (each round gets and releases its blocks)
+template <typename _Allocator>
+void grow_and_shrink(_Allocator &allocator, Recorder &allocs,
+                     Recorder &frees) {
+  TrimPolicy policy;
+  policy.spare_blocks = 0;
+  allocator.set_trim_policy(policy);
+
+  const std::size_t count = 8;
+  std::vector<ScalarType *> ptrs(std::size_t(1) << 15);
+  std::mt19937 generator{};
+  for (std::size_t round = 0; round < scale * 32; ++round) {
+    for (auto &ptr : ptrs) {
+      allocs.time([&]() { ptr = allocator.allocate(count); });
+    }
+    std::shuffle(ptrs.begin(), ptrs.end(), generator);
+    for (auto ptr : ptrs) {
+      frees.time([&]() { allocator.deallocate(ptr, count); });
+    }
+  }
+}
+
+/// Random sizes (a few of them too large for a block) and random frees. With
+/// \ref recycle_every > 0, every that many frees also recycle the slots
+template <typename _Allocator>
+void mixed_sizes(_Allocator &allocator, Recorder &allocs, Recorder &frees,
+                 std::size_t recycle_every) {
+  const std::size_t n_live = std::size_t(1) << 13;
+  std::vector<std::pair<ScalarType *, std::size_t>> ptrs(n_live);
+  std::mt19937 generator{};
+  std::uniform_int_distribution<std::size_t> pick_size(1, 64);
+  std::uniform_int_distribution<std::size_t> pick(0, n_live - 1);
+  auto size = [&]() {
+    return generator() % 256 == 0 ? 2 * _Allocator::max_count()
+                                  : pick_size(generator);
+  };
+
+  for (auto &ptr : ptrs) {
+    ptr.second = size();
+    ptr.first = allocator.allocate(ptr.second);
+  }
+  std::size_t n_frees = 0;
+  for (std::size_t i = 0; i < scale * (std::size_t(1) << 19); ++i) {
+    auto &ptr = ptrs[pick(generator)];
+    frees.time([&]() {
+      allocator.deallocate(ptr.first, ptr.second);
+      if (recycle_every > 0 && ++n_frees % recycle_every == 0) {
+        allocator.recycle_slots();
+      }
+    });
+    ptr.second = size();
+    allocs.time([&]() { ptr.first = allocator.allocate(ptr.second); });
+  }
+  for (auto &ptr : ptrs) {
+    allocator.deallocate(ptr.first, ptr.second);
+  }
+}
+
+/// The first allocations of a fresh pool (each one timed along with the
+/// first write to it), \ref warm: after reserving and faulting in its blocks
+template <typename _Allocator>
+void cold_start(_Allocator &allocator, Recorder &allocs, Recorder &frees,
+                bool warm) {
+  const std::size_t n_allocations = scale * (std::size_t(1) << 18);
+  const std::size_t max_count = 8;
+  if (warm) {
+    allocator.reserve(n_allocations * max_count);
+    allocator.prefault();
+  }
+
+  std::mt19937 generator{};
+  std::uniform_int_distribution<std::size_t> pick_size(1, max_count);
+  std::vector<std::pair<ScalarType *, std::size_t>> ptrs(n_allocations);
+  for (auto &ptr : ptrs) {
+    ptr.second = pick_size(generator);
+    allocs.time([&]() {
+      ptr.first = allocator.allocate(ptr.second);
+      ptr.first[ptr.second - 1] = 0.;
+    });
+  }
+  for (auto &ptr : ptrs) {
+    frees.time([&]() { allocator.deallocate(ptr.first, ptr.second); });
+  }
+}
+
+template <bool _Recycle_Slots>
+void run(const char *workload, const char *name, double ns,
+         std::size_t recycle_every = 0) {
+  PoolAllocator<ScalarType, BlockSize, _Recycle_Slots> allocator;
+  Recorder allocs, frees;
+  const std::string kind(workload);
+  if (kind == "single_slots") {
+    single_slots(allocator, allocs, frees);
+  } else if (kind == "grow_and_shrink") {
+    grow_and_shrink(allocator, allocs, frees);
+  } else if (kind == "cold_start") {
+    cold_start(allocator, allocs, frees, false);
+  } else if (kind == "cold_start, reserved and prefaulted") {
+    cold_start(allocator, allocs, frees, true);
+  } else {
+    mixed_sizes(allocator, allocs, frees, recycle_every);
+  }
+
+  std::printf("%s, %s\n", workload, name);
+  report("allocate", allocs, ns);
+  report("deallocate", frees, ns);
+}
+
+int main(int argc, char *argv[]) {
+  scale = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1;
+  const double ns = ns_per_tick();
+
+  for (const char *workload :
+       {"single_slots", "grow_and_shrink", "mixed_sizes"}) {
+    run<false>(workload, "pool", ns);
+    run<true>(workload, "pool + recycle", ns);
+  }
+  run<false>("mixed_sizes, recycle_slots every 4096 frees", "pool", ns,
+             4096);
+  run<true>("cold_start", "pool + recycle", ns);
+  run<true>("cold_start, reserved and prefaulted", "pool + recycle", ns);
+  return 0;
+}
@@ -0,0 +1,103 @@
+//
+//  bench_monotonic.cpp
+//  memorypool
+//
+//  Request handlers: every request builds a list, a map and records of random
+//  lengths, then drops all of them. Pools free every node and record one by
+//  one, the monotonic arena does nothing per object and is reset after the
+//  request. Also prints the blocks each allocator holds at the end
+//  Usage: bench_monotonic [requests]
+//
+
+#include "../monotonicArena.hpp"
+#include "../poolArena.hpp"
+#include "bench_util.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <random>
+#include <vector>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+
+/// Objects allocated by a request
+const std::size_t ObjectsPerRequest = 4096;
+
+/// @brief Handles one request with containers on \ref allocator
+template <typename _Allocator>
+std::uint64_t handle_request(const _Allocator &allocator,
+                             std::mt19937 &generator) {
+  using list_allocator =
+      typename std::allocator_traits<_Allocator>::template rebind_alloc<
+          std::uint64_t>;
+  using map_allocator =
+      typename std::allocator_traits<_Allocator>::template rebind_alloc<
+          std::pair<const std::uint32_t, std::uint64_t>>;
+
+  std::list<std::uint64_t, list_allocator> list(allocator);
+  std::map<std::uint32_t, std::uint64_t, std::less<std::uint32_t>,
+           map_allocator>
+      map(allocator);
+  using record = std::vector<std::uint64_t, list_allocator>;
+  std::vector<record, typename std::allocator_traits<_Allocator>::
+                          template rebind_alloc<record>>
+      records(allocator);
+  for (std::size_t i = 0; i < ObjectsPerRequest; ++i) {
+    const std::uint32_t key = generator();
+    list.push_back(key);
+    map.emplace(key, i);
+    records.emplace_back(1 + key % 32, key, allocator);
+  }
+
+  std::uint64_t sum = 0;
+  for (auto &entry : map) {
+    sum += entry.second;
+  }
+  return sum + list.front() + records.back().front();
+}
+
+/// @brief Handles \ref n_requests, calling \ref done after each one
+template <typename _Allocator, typename _Done>
+double run(std::size_t n_requests, const _Allocator &allocator,
+           _Done &&done) {
+  std::uint64_t sum = 0;
+  const double seconds = time_best_of(5, [&]() {
+    std::mt19937 generator{};
+    for (std::size_t i = 0; i < n_requests; ++i) {
+      sum += handle_request(allocator, generator);
+      done();
+    }
+  });
+  if (sum == 0) {
+    std::printf("empty\n");
+  }
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t n_requests =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+  std::printf("%zu requests of %zu objects\n", n_requests, ObjectsPerRequest);
+
+  const double baseline =
+      run(n_requests, std::allocator<std::uint64_t>(), []() {});
+  report("std::allocator", baseline, baseline);
+
+  ArenaAllocator<std::uint64_t, BlockSize> pool;
+  report("ArenaAllocator", run(n_requests, pool, []() {}), baseline);
+
+  ArenaAllocator<std::uint64_t, BlockSize, true> recycling;
+  report("ArenaAllocator + recycle", run(n_requests, recycling, []() {}),
+         baseline);
+
+  MonotonicAllocator<std::uint64_t, BlockSize> monotonic;
+  report("MonotonicAllocator + reset",
+         run(n_requests, monotonic, [&]() { monotonic.arena()->reset(); }),
+         baseline);
+  std::printf("blocks held: pool %zu, recycling pool %zu, monotonic %zu\n",
+              pool.arena()->blocks(), recycling.arena()->blocks(),
+              monotonic.arena()->blocks());
+  return 0;
+}
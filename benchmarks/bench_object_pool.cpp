@@ -0,0 +1,93 @@
+//
+//  bench_object_pool.cpp
+//  memorypool
+//
+//  Recycled messages, each owning a 1 KiB payload: ObjectPool against the
+//  deprecated SmartObjectPool (a deque behind a mutex, and a weak_ptr in every
+//  handle) and against make_unique, which constructs every message anew.
+//  Both pools are warmed up beforehand, from 1 to N threads
+//  Usage: bench_object_pool [max_threads]
+//
+
+// The deprecated pool is benchmarked as it is, warnings included
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpessimizing-move"
+#endif
+#include "../deprecated/memorypool.hpp"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+#include "../objectPool.hpp"
+#include "bench_util.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+
+struct Message {
+  Message() : payload(1024) {}
+
+  std::vector<std::uint8_t> payload;
+};
+
+const std::size_t rounds = 1 << 11;
+const std::size_t batch = 1 << 6;
+
+/// Each thread repeatedly takes a batch of messages and gives it back
+template <typename _Acquire>
+double throughput(std::size_t n_threads, _Acquire &&acquire) {
+  auto work = [&]() {
+    using handle = decltype(acquire());
+    std::vector<handle> messages;
+    messages.reserve(batch);
+    for (std::size_t round = 0; round < rounds; ++round) {
+      for (std::size_t i = 0; i < batch; ++i) {
+        messages.push_back(acquire());
+        messages.back()->payload[round % 1024] = 1;
+      }
+      messages.clear();
+    }
+  };
+
+  const double seconds = time_best_of(3, [&]() {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < n_threads; ++i) {
+      threads.emplace_back(work);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  });
+  return 2. * rounds * batch * n_threads / seconds;
+}
+
+int main(int argc, char **argv) {
+  const std::size_t max_threads =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+               : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+  std::printf("%8s %16s %16s %16s %8s\n", "threads", "new (Mops/s)",
+              "smart (Mops/s)", "pool (Mops/s)", "speedup");
+  for (std::size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    SmartObjectPool<Message> smart;
+    for (std::size_t i = 0; i < n_threads * batch; ++i) {
+      smart.push_front(new Message());
+    }
+    ObjectPool<Message, BlockSize> pool(n_threads * batch);
+
+    const double new_ops =
+        throughput(n_threads, []() { return std::make_unique<Message>(); });
+    const double smart_ops =
+        throughput(n_threads, [&]() { return smart.pop(); });
+    const double pool_ops =
+        throughput(n_threads, [&]() { return pool.acquire(); });
+    std::printf("%8zu %16.2f %16.2f %16.2f %7.2fx\n", n_threads,
+                new_ops * 1e-6, smart_ops * 1e-6, pool_ops * 1e-6,
+                pool_ops / smart_ops);
+  }
+  return 0;
+}
@@ -0,0 +1,319 @@
+//
+//  bench_patterns.cpp
+//  memorypool
+//
+//  Allocation patterns (LIFO, FIFO, random order, mixed sizes and container
+//  churn) against the PoolAllocator with and without recycling, std::allocator
+//  and a std::pmr pool. Prints ops/s and peak RSS of every run as JSON; each
+//  run happens in a child process so that its peak RSS is its own.
+//  Usage: bench_patterns [scale]
+//
+
+#include "../poolArena.hpp"
+#include "bench_util.hpp"
+
+#include <cstdlib>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+const std::size_t BlockSize = 32 * detail::KiB;
+using ScalarType = double;
+
+/// @brief The allocators under test, as families of allocator types
+template <bool _Recycle_Slots> struct PoolFamily {
+  template <typename _Tp>
+  using allocator = ArenaAllocator<_Tp, BlockSize, _Recycle_Slots>;
+  template <typename _Tp> allocator<_Tp> make() { return allocator<_Tp>(); }
+};
+
+struct StdFamily {
+  template <typename _Tp> using allocator = std::allocator<_Tp>;
+  template <typename _Tp> allocator<_Tp> make() { return allocator<_Tp>(); }
+};
+
+struct PmrFamily {
+  template <typename _Tp>
+  using allocator = std::pmr::polymorphic_allocator<_Tp>;
+  template <typename _Tp> allocator<_Tp> make() {
+    return allocator<_Tp>(&resource_);
+  }
+
+  std::pmr::unsynchronized_pool_resource resource_;
+};
+
+/// Objects alive at once and rounds of every pattern (times the scale)
+std::size_t n_objects = std::size_t(1) << 16;
+std::size_t n_rounds = 8;
+
+/// @brief Frees in the reverse order of allocation. Returns the operations
+template <class _Family> std::size_t lifo(_Family &family) {
+  auto allocator = family.template make<ScalarType>();
+  std::vector<ScalarType *> ptrs(n_objects);
+  for (std::size_t round = 0; round < n_rounds; ++round) {
+    for (auto &ptr : ptrs) {
+      ptr = allocator.allocate(1);
+      *ptr = round;
+    }
+    for (auto ptr = ptrs.rbegin(); ptr != ptrs.rend(); ++ptr) {
+      allocator.deallocate(*ptr, 1);
+    }
+  }
+  return 2 * n_rounds * n_objects;
+}
+
+/// @brief Frees in the order of allocation
+template <class _Family> std::size_t fifo(_Family &family) {
+  auto allocator = family.template make<ScalarType>();
+  std::vector<ScalarType *> ptrs(n_objects);
+  for (std::size_t round = 0; round < n_rounds; ++round) {
+    for (auto &ptr : ptrs) {
+      ptr = allocator.allocate(1);
+      *ptr = round;
+    }
+    for (auto ptr : ptrs) {
+      allocator.deallocate(ptr, 1);
+    }
+  }
+  return 2 * n_rounds * n_objects;
+}
+
+/// @brief Frees in a random order
+template <class _Family> std::size_t random_order(_Family &family) {
+  auto allocator = family.template make<ScalarType>();
+  std::vector<ScalarType *> ptrs(n_objects);
+  std::vector<std::size_t> order(n_objects);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), std::mt19937{});
+
+  for (std::size_t round = 0; round < n_rounds; ++round) {
+    for (auto &ptr : ptrs) {
+      ptr = allocator.allocate(1);
+      *ptr = round;
+    }
+    for (auto i : order) {
+      allocator.deallocate(ptrs[i], 1);
+    }
+  }
+  return 2 * n_rounds * n_objects;
+}
+
+/// @brief 1 to 64 elements per allocation, a random live one replaced at each
+/// step
+template <class _Family> std::size_t mixed_sizes(_Family &family) {
+  auto allocator = family.template make<ScalarType>();
+  std::mt19937 generator{};
+  std::uniform_int_distribution<std::size_t> pick_count(1, 64);
+
+  std::vector<std::pair<ScalarType *, std::size_t>> ptrs(n_objects / 8);
+  for (auto &ptr : ptrs) {
+    ptr.second = pick_count(generator);
+    ptr.first = allocator.allocate(ptr.second);
+  }
+  const std::size_t steps = n_rounds * n_objects;
+  for (std::size_t step = 0; step < steps; ++step) {
+    auto &ptr = ptrs[generator() % ptrs.size()];
+    allocator.deallocate(ptr.first, ptr.second);
+    ptr.second = pick_count(generator);
+    ptr.first = allocator.allocate(ptr.second);
+    ptr.first[ptr.second - 1] = step;
+  }
+  for (auto &ptr : ptrs) {
+    allocator.deallocate(ptr.first, ptr.second);
+  }
+  return 2 * (steps + ptrs.size());
+}
+
+/// @brief A queue: push at the back, pop at the front
+template <class _Family> std::size_t deque_churn(_Family &family) {
+  std::deque<ScalarType, typename _Family::template allocator<ScalarType>>
+      queue(family.template make<ScalarType>());
+  for (std::size_t round = 0; round < n_rounds; ++round) {
+    for (std::size_t i = 0; i < n_objects; ++i) {
+      queue.push_back(i);
+      if (i % 3 == 0) {
+        queue.pop_front();
+      }
+    }
+    queue.clear();
+  }
+  return n_rounds * (n_objects + n_objects / 3);
+}
+
+/// @brief Inserts and erases nodes in the middle
+template <class _Family> std::size_t list_churn(_Family &family) {
+  std::list<ScalarType, typename _Family::template allocator<ScalarType>>
+      list(family.template make<ScalarType>());
+  for (std::size_t round = 0; round < n_rounds; ++round) {
+    for (std::size_t i = 0; i < n_objects; ++i) {
+      list.push_back(i);
+    }
+    for (auto node = list.begin(); node != list.end();) {
+      node = list.erase(node);
+      if (node != list.end()) {
+        ++node;
+      }
+    }
+    list.clear();
+  }
+  return 2 * n_rounds * n_objects;
+}
+
+/// @brief Random inserts and erases in a (node based) tree
+template <class _Family> std::size_t map_churn(_Family &family) {
+  using value_type = std::pair<const int, ScalarType>;
+  std::map<int, ScalarType, std::less<int>,
+           typename _Family::template allocator<value_type>>
+      map(family.template make<value_type>());
+  std::mt19937 generator{};
+  const int keys = static_cast<int>(n_objects);
+  const std::size_t steps = n_rounds * n_objects;
+  for (std::size_t step = 0; step < steps; ++step) {
+    const int key = static_cast<int>(generator() % keys);
+    if (!map.emplace(key, step).second) {
+      map.erase(key);
+    }
+  }
+  return steps;
+}
+
+/// @brief Random inserts and erases in a hash table
+template <class _Family> std::size_t unordered_map_churn(_Family &family) {
+  using value_type = std::pair<const int, ScalarType>;
+  std::unordered_map<int, ScalarType, std::hash<int>, std::equal_to<int>,
+                     typename _Family::template allocator<value_type>>
+      map(0, std::hash<int>(), std::equal_to<int>(),
+          family.template make<value_type>());
+  std::mt19937 generator{};
+  const int keys = static_cast<int>(n_objects);
+  const std::size_t steps = n_rounds * n_objects;
+  for (std::size_t step = 0; step < steps; ++step) {
+    const int key = static_cast<int>(generator() % keys);
+    if (!map.emplace(key, step).second) {
+      map.erase(key);
+    }
+  }
+  return steps;
+}
+
+struct Result {
+  std::size_t ops;
+  double seconds;
+  long peak_rss_kib;
+};
+
+/// @brief Peak resident set size of the process (KiB), -1 if unknown
+long peak_rss() {
+#if defined(__unix__) || defined(__APPLE__)
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return -1;
+#endif
+}
+
+/// @brief Runs \ref pattern on a new \ref _Family of allocators
+template <class _Family, class _Pattern> Result measure(_Pattern &&pattern) {
+  Result result;
+  const long rss_before = peak_rss();
+  {
+    _Family family;
+    std::size_t ops = 0;
+    result.seconds = time_best_of(1, [&]() { ops = pattern(family); });
+    result.ops = ops;
+  }
+  result.peak_rss_kib = peak_rss() - rss_before;
+  return result;
+}
+
+/// Whether no result was printed yet
+bool first_result = true;
+
+/// @brief Runs \ref pattern in a child process and prints it as JSON
+template <class _Family, class _Pattern>
+void run(const char *pattern_name, const char *allocator_name,
+         _Pattern &&pattern) {
+  Result result{0, 0., -1};
+#if defined(__unix__) || defined(__APPLE__)
+  int pipe_fds[2];
+  if (pipe(pipe_fds) == 0) {
+    std::fflush(stdout);
+    const pid_t child = fork();
+    if (child == 0) {
+      close(pipe_fds[0]);
+      result = measure<_Family>(pattern);
+      const bool written =
+          write(pipe_fds[1], &result, sizeof(result)) == sizeof(result);
+      _exit(written ? 0 : 1);
+    }
+    close(pipe_fds[1]);
+    if (child < 0 ||
+        read(pipe_fds[0], &result, sizeof(result)) != sizeof(result)) {
+      result = Result{0, 0., -1};
+    }
+    close(pipe_fds[0]);
+    if (child > 0) {
+      waitpid(child, nullptr, 0);
+    }
+  }
+#else
+  result = measure<_Family>(pattern);
+#endif
+  std::printf("%s\n    {\"pattern\": \"%s\", \"allocator\": \"%s\", "
+              "\"ops\": %zu, \"seconds\": %.6f, \"ops_per_sec\": %.0f, "
+              "\"peak_rss_kib\": %ld}",
+              first_result ? "" : ",", pattern_name, allocator_name, result.ops,
+              result.seconds,
+              result.seconds > 0. ? result.ops / result.seconds : 0.,
+              result.peak_rss_kib);
+  first_result = false;
+}
+
+/// @brief Runs \ref pattern against every allocator
+#define RUN_PATTERN(pattern)                                                   \
+  run<PoolFamily<false>>(#pattern, "pool",                                     \
+                         [](PoolFamily<false> &f) { return pattern(f); });     \
+  run<PoolFamily<true>>(#pattern, "pool_recycle",                              \
+                        [](PoolFamily<true> &f) { return pattern(f); });       \
+  run<StdFamily>(#pattern, "std_allocator",                                    \
+                 [](StdFamily &f) { return pattern(f); });                     \
+  run<PmrFamily>(#pattern, "pmr_unsynchronized_pool",                          \
+                 [](PmrFamily &f) { return pattern(f); });
+
+int main(int argc, char *argv[]) {
+  const std::size_t scale =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1;
+  n_rounds *= scale > 0 ? scale : 1;
+
+  std::printf("{\n  \"benchmark\": \"patterns\",\n  \"block_size\": %zu,\n"
+              "  \"results\": [",
+              BlockSize);
+
+  RUN_PATTERN(lifo)
+  RUN_PATTERN(fifo)
+  RUN_PATTERN(random_order)
+  RUN_PATTERN(mixed_sizes)
+  RUN_PATTERN(deque_churn)
+  RUN_PATTERN(list_churn)
+  RUN_PATTERN(map_churn)
+  RUN_PATTERN(unordered_map_churn)
+
+  std::printf("\n  ]\n}\n");
+  return 0;
+}
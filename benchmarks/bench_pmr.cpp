@@ -0,0 +1,153 @@
+//
+//  bench_pmr.cpp
+//  memorypool
+//
+//  std::pmr containers on PoolResource, against the standard resources:
+//  new_delete_resource, unsynchronized_pool_resource (over new_delete and
+//  over a PoolResource) and monotonic_buffer_resource, which never frees
+//  before it is destroyed
+//  Usage: bench_pmr [scale]
+//
+
+#include "../poolResource.hpp"
+#include "bench_util.hpp"
+
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+
+std::size_t scale = 1;
+
+/// Appends to a list and pops from its front, keeping 4096 nodes alive
+void list_churn(std::pmr::memory_resource *resource) {
+  std::pmr::list<double> list(resource);
+  for (std::size_t i = 0; i < scale * (std::size_t(1) << 20); ++i) {
+    list.push_back(static_cast<double>(i));
+    if (list.size() > 4096) {
+      list.pop_front();
+    }
+  }
+}
+
+/// Inserts and erases random keys, keeping about 32768 entries
+void map_churn(std::pmr::memory_resource *resource) {
+  std::pmr::map<std::uint32_t, std::uint64_t> map(resource);
+  std::mt19937 generator{};
+  for (std::size_t i = 0; i < scale * (std::size_t(1) << 19); ++i) {
+    const std::uint32_t key = generator() % 65536;
+    auto entry = map.find(key);
+    if (entry == map.end()) {
+      map.emplace(key, i);
+    } else {
+      map.erase(entry);
+    }
+  }
+}
+
+/// Vectors and strings of random sizes, growing one element at a time
+void vectors(std::pmr::memory_resource *resource) {
+  std::mt19937 generator{};
+  std::pmr::vector<std::pmr::vector<int>> vectors(resource);
+  std::pmr::vector<std::pmr::string> strings(resource);
+  for (std::size_t i = 0; i < scale * 4096; ++i) {
+    std::pmr::vector<int> vector(resource);
+    std::pmr::string string(resource);
+    for (std::size_t j = generator() % 512; j > 0; --j) {
+      vector.push_back(static_cast<int>(j));
+      string.push_back('a');
+    }
+    vectors.push_back(std::move(vector));
+    strings.push_back(std::move(string));
+    if (vectors.size() > 256) {
+      vectors.erase(vectors.begin() + generator() % vectors.size());
+      strings.erase(strings.begin() + generator() % strings.size());
+    }
+  }
+}
+
+/// Random sizes and alignments, freed in random order
+void mixed_sizes(std::pmr::memory_resource *resource) {
+  struct Allocation {
+    void *ptr;
+    std::size_t size, alignment;
+  };
+  std::mt19937 generator{};
+  std::vector<Allocation> alive(8192, Allocation{nullptr, 0, 0});
+  for (std::size_t i = 0; i < scale * (std::size_t(1) << 20); ++i) {
+    Allocation &allocation = alive[generator() % alive.size()];
+    if (allocation.ptr != nullptr) {
+      resource->deallocate(allocation.ptr, allocation.size,
+                           allocation.alignment);
+    }
+    allocation.size = 1 + generator() % 512;
+    allocation.alignment = std::size_t(1) << (generator() % 5);
+    allocation.ptr = resource->allocate(allocation.size, allocation.alignment);
+  }
+  for (Allocation &allocation : alive) {
+    if (allocation.ptr != nullptr) {
+      resource->deallocate(allocation.ptr, allocation.size,
+                           allocation.alignment);
+    }
+  }
+}
+
+template <typename _Workload>
+void run(const char *name, _Workload &&workload) {
+  const std::size_t repetitions = 5;
+  std::printf("%s\n", name);
+
+  const double baseline = time_best_of(
+      repetitions, [&]() { workload(std::pmr::new_delete_resource()); });
+  report("new_delete_resource", baseline, baseline);
+
+  report("unsynchronized_pool_resource", time_best_of(repetitions, [&]() {
+           std::pmr::unsynchronized_pool_resource resource;
+           workload(&resource);
+         }),
+         baseline);
+
+  report("monotonic_buffer_resource", time_best_of(repetitions, [&]() {
+           std::pmr::monotonic_buffer_resource resource;
+           workload(&resource);
+         }),
+         baseline);
+
+  report("PoolResource", time_best_of(repetitions, [&]() {
+           PoolResource<BlockSize> resource;
+           workload(&resource);
+         }),
+         baseline);
+
+  report("PoolResource + recycle", time_best_of(repetitions, [&]() {
+           PoolResource<BlockSize, true> resource;
+           workload(&resource);
+         }),
+         baseline);
+
+  report("unsynchronized_pool over PoolResource",
+         time_best_of(repetitions,
+                      [&]() {
+                        PoolResource<BlockSize> upstream;
+                        std::pmr::unsynchronized_pool_resource resource(
+                            &upstream);
+                        workload(&resource);
+                      }),
+         baseline);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    scale = std::strtoul(argv[1], nullptr, 10);
+  }
+  run("list churn", list_churn);
+  run("map churn", map_churn);
+  run("vectors and strings", vectors);
+  run("mixed sizes and alignments", mixed_sizes);
+  return 0;
+}
@@ -0,0 +1,65 @@
+//
+//  bench_queue.cpp
+//  memorypool
+//
+//  Lock-free MPMCQueue against the mutex based ThreadSafeQueue, with 1 to 16
+//  producers and as many consumers
+//
+
+#include "../mpmcQueue.hpp"
+#include "../threadSafeQueue.hpp"
+#include "bench_util.hpp"
+
+#include <cstdlib>
+#include <thread>
+
+const std::size_t n_items = 1 << 16; // per producer
+
+/// Runs \ref n_pairs producers and \ref n_pairs consumers and returns the
+/// number of items moved through the queue per second
+template <typename _Push, typename _Pop>
+double throughput(std::size_t n_pairs, _Push &&push, _Pop &&pop) {
+  const double seconds = time_best_of(3, [&]() {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < n_pairs; ++i) {
+      threads.emplace_back([&]() {
+        for (std::size_t j = 0; j < n_items; ++j) {
+          push(j);
+        }
+      });
+      threads.emplace_back([&]() {
+        for (std::size_t j = 0; j < n_items; ++j) {
+          pop();
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  });
+  return n_pairs * n_items / seconds;
+}
+
+/// Usage: bench_queue [max_pairs]
+int main(int argc, char **argv) {
+  const std::size_t max_pairs =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+
+  std::printf("%16s %20s %20s %8s\n", "producers/cons.", "mutex (Mitems/s)",
+              "lock-free (Mitems/s)", "speedup");
+  for (std::size_t n_pairs = 1; n_pairs <= max_pairs; n_pairs *= 2) {
+    ThreadSafeQueue<std::size_t> locked;
+    MPMCQueue<std::size_t> lock_free(1 << 12);
+
+    const double locked_items = throughput(
+        n_pairs, [&](std::size_t item) { locked.push_back(std::move(item)); },
+        [&]() { locked.pop_front(); });
+    const double lock_free_items = throughput(
+        n_pairs, [&](std::size_t item) { lock_free.push(item); },
+        [&]() { lock_free.pop(); });
+
+    std::printf("%16zu %20.2f %20.2f %7.2fx\n", n_pairs, locked_items * 1e-6,
+                lock_free_items * 1e-6, lock_free_items / locked_items);
+  }
+  return 0;
+}
@@ -0,0 +1,261 @@
+//
+//  bench_replay.cpp
+//  memorypool
+//
+//  Replays an allocation trace (see allocationTrace.hpp) against
+//  std::allocator and PoolAllocator configurations: block sizes, with and
+//  without recycling, size classes against a single first-fit list. Reports
+//  the throughput, the peak of the reserved memory and the fragmentation at
+//  that peak, and the free chunk scans.
+//  Usage: bench_replay <trace>
+//         bench_replay --synthesize <trace> [events]   writes a test trace
+//
+
+#define POOL_STATS_ENABLED
+
+#include "../allocationTrace.hpp"
+#include "bench_util.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+/// @brief A trace event, the objects renamed to dense indices
+struct Event {
+  std::uint32_t object;
+  std::uint32_t count;
+  bool allocate;
+};
+
+/// @brief Renames the objects of \ref records and drops the deallocations of
+/// objects allocated before the trace started. Returns the number of objects
+/// (the most ever alive at once)
+std::size_t prepare(const std::vector<TraceRecord> &records,
+                    std::vector<Event> &events) {
+  std::unordered_map<std::uint64_t, std::uint32_t> alive;
+  std::vector<std::uint32_t> unused;
+  std::uint32_t n_objects = 0;
+  for (const TraceRecord &record : records) {
+    if (record.op == TraceOp::Allocate) {
+      std::uint32_t object;
+      if (!unused.empty()) {
+        object = unused.back();
+        unused.pop_back();
+      } else {
+        object = n_objects++;
+      }
+      alive[record.object] = object;
+      events.push_back(Event{object, record.count, true});
+    } else {
+      auto entry = alive.find(record.object);
+      if (entry == alive.end()) {
+        continue;
+      }
+      events.push_back(Event{entry->second, record.count, false});
+      unused.push_back(entry->second);
+      alive.erase(entry);
+    }
+  }
+  return n_objects;
+}
+
+/// @brief Elements of the traced size
+template <std::size_t _Size> struct Element {
+  std::uint64_t words[_Size / sizeof(std::uint64_t)];
+};
+
+struct Result {
+  double seconds = 0.;
+  /// When the most memory was reserved, and at the end of the trace
+  PoolStats peak;
+  PoolStats end;
+};
+
+/// @brief Runs the events in order, calling \ref sample every now and then
+template <typename _Allocator, typename _Sample>
+void replay(_Allocator &allocator, const std::vector<Event> &events,
+            std::size_t n_objects, std::size_t period, _Sample &&sample) {
+  using pointer = typename std::allocator_traits<_Allocator>::pointer;
+  std::vector<std::pair<pointer, std::size_t>> objects(n_objects);
+  std::size_t next = period;
+  for (const Event &event : events) {
+    auto &object = objects[event.object];
+    if (event.allocate) {
+      object.first = allocator.allocate(event.count);
+      object.second = event.count;
+    } else {
+      allocator.deallocate(object.first, event.count);
+      object.first = nullptr;
+    }
+    if (--next == 0) {
+      sample();
+      next = period;
+    }
+  }
+  sample();
+  // The objects still alive at the end of the trace
+  for (auto &object : objects) {
+    if (object.first != nullptr) {
+      allocator.deallocate(object.first, object.second);
+    }
+  }
+}
+
+template <typename _Allocator>
+Result run(const std::vector<Event> &events, std::size_t n_objects) {
+  Result result;
+  // NOTE: Once only, a first-fit scan over a long trace takes a while
+  result.seconds = time_best_of(1, [&]() {
+    _Allocator allocator;
+    replay(allocator, events, n_objects, events.size() + 1, []() {});
+  });
+  return result;
+}
+
+/// @brief Same, then replays again sampling the statistics of the pool
+template <typename _Tp, std::size_t _Block_Size, bool _Recycle_Slots,
+          std::size_t _Size_Classes>
+Result run_pool(const std::vector<Event> &events, std::size_t n_objects) {
+  using Allocator =
+      PoolAllocator<_Tp, _Block_Size, _Recycle_Slots, _Size_Classes>;
+  Result result = run<Allocator>(events, n_objects);
+
+  Allocator allocator;
+  const std::size_t period = std::max<std::size_t>(events.size() / 1024, 1);
+  replay(allocator, events, n_objects, period, [&]() {
+    result.end = allocator.stats();
+    if (result.end.bytes_reserved >= result.peak.bytes_reserved) {
+      result.peak = result.end;
+    }
+  });
+  return result;
+}
+
+void report(const char *name, const Result &result, std::size_t n_events,
+            bool pool) {
+  std::printf("%-30s %8.2f Mev/s", name, n_events / result.seconds / 1e6);
+  if (pool) {
+    std::printf("  peak %9.2f MiB  fragmentation %5.3f  scan avg %6.2f max "
+                "%6zu  blocks %zu",
+                static_cast<double>(result.peak.bytes_reserved) / detail::MiB,
+                result.peak.fragmentation, result.end.average_scan(),
+                result.end.max_scan, result.end.blocks_allocated);
+  }
+  std::printf("\n");
+}
+
+template <typename _Tp, std::size_t _Block_Size>
+void run_block_size(const std::vector<Event> &events, std::size_t n_objects) {
+  const std::size_t classes = detail::size_classes(_Block_Size);
+  char name[64];
+  std::snprintf(name, sizeof(name), "pool %zu KiB", _Block_Size / detail::KiB);
+  report(name, run_pool<_Tp, _Block_Size, false, classes>(events, n_objects),
+         events.size(), true);
+  std::snprintf(name, sizeof(name), "pool %zu KiB + recycle",
+                _Block_Size / detail::KiB);
+  report(name, run_pool<_Tp, _Block_Size, true, classes>(events, n_objects),
+         events.size(), true);
+  std::snprintf(name, sizeof(name), "pool %zu KiB, first fit",
+                _Block_Size / detail::KiB);
+  report(name, run_pool<_Tp, _Block_Size, false, 1>(events, n_objects),
+         events.size(), true);
+}
+
+template <typename _Tp>
+void run_all(const std::vector<Event> &events, std::size_t n_objects) {
+  report("std::allocator", run<std::allocator<_Tp>>(events, n_objects),
+         events.size(), false);
+  run_block_size<_Tp, 4 * detail::KiB>(events, n_objects);
+  run_block_size<_Tp, 32 * detail::KiB>(events, n_objects);
+  run_block_size<_Tp, 256 * detail::KiB>(events, n_objects);
+  run_block_size<_Tp, 2 * detail::MiB>(events, n_objects);
+}
+
+/// @brief Writes a trace of random sizes freed in random order
+bool synthesize(const char *path, std::size_t n_events) {
+  TraceHeader header;
+  header.element_size = sizeof(double);
+  detail::TraceWriter writer;
+  if (!writer.open(path, header)) {
+    return false;
+  }
+
+  std::mt19937 generator{};
+  std::uniform_int_distribution<std::size_t> pick_size(1, 32);
+  std::vector<std::pair<std::uintptr_t, std::size_t>> alive;
+  std::uintptr_t next = 64;
+  for (std::size_t i = 0; i < n_events; ++i) {
+    // Grows for the first half of the trace, then shrinks
+    const bool grow = i < n_events / 2 ? generator() % 3 != 0
+                                       : generator() % 3 == 0;
+    if (grow || alive.empty()) {
+      const std::size_t count =
+          generator() % 8 == 0 ? 1 : pick_size(generator);
+      alive.emplace_back(next, count);
+      writer.record(TraceOp::Allocate, reinterpret_cast<void *>(next), count);
+      next += 64;
+    } else {
+      std::swap(alive[generator() % alive.size()], alive.back());
+      writer.record(TraceOp::Deallocate,
+                    reinterpret_cast<void *>(alive.back().first),
+                    alive.back().second);
+      alive.pop_back();
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 2 && std::strcmp(argv[1], "--synthesize") == 0) {
+    const std::size_t n_events =
+        argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::size_t(1) << 19;
+    return synthesize(argv[2], n_events) ? 0 : 1;
+  }
+  if (argc != 2) {
+    std::fprintf(stderr, "Usage: %s <trace>\n"
+                         "       %s --synthesize <trace> [events]\n",
+                 argv[0], argv[0]);
+    return 1;
+  }
+
+  TraceHeader header;
+  std::vector<TraceRecord> records;
+  if (!read_trace(argv[1], header, records)) {
+    std::fprintf(stderr, "%s: not a trace\n", argv[1]);
+    return 1;
+  }
+  std::vector<Event> events;
+  const std::size_t n_objects = prepare(records, events);
+  std::printf("%zu events, %zu objects at most, %u byte elements\n",
+              events.size(), n_objects, header.element_size);
+  if (header.block_size > 0) {
+    std::printf("recorded by a pool of %llu byte blocks%s\n",
+                static_cast<unsigned long long>(header.block_size),
+                header.recycle_slots ? " recycling slots" : "");
+  }
+
+  // NOTE: Other sizes are replayed as as many 8 byte words
+  switch (header.element_size) {
+  case 8:
+    run_all<Element<8>>(events, n_objects);
+    break;
+  case 16:
+    run_all<Element<16>>(events, n_objects);
+    break;
+  case 32:
+    run_all<Element<32>>(events, n_objects);
+    break;
+  case 64:
+    run_all<Element<64>>(events, n_objects);
+    break;
+  default:
+    for (Event &event : events) {
+      event.count = static_cast<std::uint32_t>(
+          (event.count * header.element_size + 7) / 8);
+    }
+    run_all<Element<8>>(events, n_objects);
+  }
+  return 0;
+}
@@ -0,0 +1,80 @@
+//
+//  bench_size_classes.cpp
+//  memorypool
+//
+//  Size class bins against the single list first-fit scan, on the pool_usage
+//  workload of tests/test_allocator.hpp
+//
+
+#include "../tests/test_allocator.hpp"
+#include "bench_util.hpp"
+
+const std::size_t BlockSize = 32 * detail::KiB;
+using ScalarType = double;
+
+/// A single size class is the original first-fit scan
+using ScanAllocator = PoolAllocator<ScalarType, BlockSize, false, 1>;
+using BinnedAllocator = PoolAllocator<ScalarType, BlockSize>;
+
+/// The pool_usage churn on a pool whose free list was first fragmented into
+/// many small chunks (every other allocation is released and never merged)
+template <typename _Allocator>
+void fragmented_usage(std::size_t n_fragments, std::size_t max_count) {
+  _Allocator allocator;
+
+  std::vector<ScalarType *> fragments(n_fragments);
+  for (std::size_t i = 0; i < n_fragments; ++i) {
+    fragments[i] = allocator.allocate(1 + i % 4);
+  }
+  for (std::size_t i = 0; i < n_fragments; i += 2) {
+    allocator.deallocate(fragments[i], 1 + i % 4);
+  }
+
+  std::mt19937 generator{};
+  std::uniform_int_distribution<std::size_t> pick(1, max_count);
+  std::vector<std::pair<ScalarType *, std::size_t>> ptrs;
+  for (std::size_t i = 0; i < 1 << 12; ++i) {
+    const std::size_t count = pick(generator);
+    ptrs.emplace_back(allocator.allocate(count), count);
+    if (i % 3 == 0) {
+      allocator.deallocate(ptrs.back().first, ptrs.back().second);
+      ptrs.pop_back();
+    }
+  }
+  for (auto &ptr : ptrs) {
+    allocator.deallocate(ptr.first, ptr.second);
+  }
+}
+
+int main() {
+  const std::size_t repetitions = 3;
+
+  for (std::size_t max_count : {1, 4, 16, 64}) {
+    std::printf("pool_usage, 1 to %zu slots per allocation\n", max_count);
+
+    const double scan = time_best_of(repetitions, [&]() {
+      pool_usage<ScalarType, BlockSize, ScanAllocator>(max_count);
+    });
+    const double binned = time_best_of(repetitions, [&]() {
+      pool_usage<ScalarType, BlockSize, BinnedAllocator>(max_count);
+    });
+
+    report("first-fit scan", scan, scan);
+    report("size classes", binned, scan);
+  }
+
+  for (std::size_t n_fragments : {1 << 10, 1 << 13, 1 << 16}) {
+    std::printf("fragmented pool_usage, %zu fragments\n", n_fragments);
+
+    const double scan = time_best_of(repetitions, [&]() {
+      fragmented_usage<ScanAllocator>(n_fragments, 16);
+    });
+    const double binned = time_best_of(repetitions, [&]() {
+      fragmented_usage<BinnedAllocator>(n_fragments, 16);
+    });
+
+    report("first-fit scan", scan, scan);
+    report("size classes", binned, scan);
+  }
+  return 0;
+}
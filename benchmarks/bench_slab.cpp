@@ -0,0 +1,92 @@
+//
+//  bench_slab.cpp
+//  memorypool
+//
+//  The bitmap SlabAllocator against the PoolAllocator's free lists, with and
+//  without recycling: batches of single elements, and runs of random lengths
+//  freed in random order (the fragmenting case). Also prints the blocks each
+//  allocator holds at the end of the fragmenting run
+//  Usage: bench_slab [scale]
+//
+
+#include "../slabAllocator.hpp"
+#include "bench_util.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+using ScalarType = double;
+
+std::size_t scale = 1;
+
+/// Allocates a batch of single elements and frees it, in the same order
+template <typename _Allocator> void singles(_Allocator &allocator) {
+  std::vector<ScalarType *> ptrs(4096);
+  for (std::size_t round = 0; round < scale * 256; ++round) {
+    for (auto &ptr : ptrs) {
+      ptr = allocator.allocate(1);
+      *ptr = 1.;
+    }
+    for (auto ptr : ptrs) {
+      allocator.deallocate(ptr, 1);
+    }
+  }
+}
+
+/// Keeps 16384 runs of 1 to 64 elements alive, replacing a random one at a
+/// time
+/// NOTE: The free chunks of a pool that does not recycle its slots fragment
+/// further with every call, so it is timed once
+template <typename _Allocator> void runs(_Allocator &allocator) {
+  struct Run {
+    ScalarType *ptr;
+    std::size_t count;
+  };
+  std::mt19937 generator{};
+  std::vector<Run> alive(16384, Run{nullptr, 0});
+  for (std::size_t i = 0; i < scale * (std::size_t(1) << 18); ++i) {
+    Run &run = alive[generator() % alive.size()];
+    if (run.ptr != nullptr) {
+      allocator.deallocate(run.ptr, run.count);
+    }
+    run.count = 1 + generator() % 64;
+    run.ptr = allocator.allocate(run.count);
+    run.ptr[run.count - 1] = 1.;
+  }
+  for (Run &run : alive) {
+    if (run.ptr != nullptr) {
+      allocator.deallocate(run.ptr, run.count);
+    }
+  }
+}
+
+template <typename _Workload>
+void run(const char *name, std::size_t repetitions, _Workload &&workload) {
+  std::printf("%s\n", name);
+  PoolAllocator<ScalarType, BlockSize> pool;
+  PoolAllocator<ScalarType, BlockSize, true> recycling;
+  SlabAllocator<ScalarType, BlockSize> slab;
+
+  const double baseline =
+      time_best_of(repetitions, [&]() { workload(pool); });
+  report("PoolAllocator", baseline, baseline);
+  report("PoolAllocator + recycle",
+         time_best_of(repetitions, [&]() { workload(recycling); }), baseline);
+  report("SlabAllocator",
+         time_best_of(repetitions, [&]() { workload(slab); }), baseline);
+  std::printf("blocks held: pool %zu, recycling pool %zu, slab %zu\n",
+              pool.blocks(), recycling.blocks(), slab.blocks());
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    scale = std::strtoul(argv[1], nullptr, 10);
+  }
+  run("single elements", 3, [](auto &allocator) { singles(allocator); });
+  run("runs of random lengths, freed in random order", 1,
+      [](auto &allocator) { runs(allocator); });
+  return 0;
+}
@@ -0,0 +1,86 @@
+//
+//  bench_thread_cache.cpp
+//  memorypool
+//
+//  Multi-threaded throughput of the thread-cached allocator against a
+//  PoolAllocator serialized by a mutex, from 1 to N threads
+//
+
+#include "../threadCache.hpp"
+#include "bench_util.hpp"
+
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+const std::size_t BlockSize = 32 * detail::KiB;
+using ScalarType = double;
+
+/// The usual workaround: a single pool behind a mutex
+template <typename _Tp, std::size_t _Block_Size> class LockedAllocator {
+public:
+  _Tp *allocate(std::size_t count) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return pool_.allocate(count);
+  }
+
+  void deallocate(_Tp *ptr, std::size_t count) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    pool_.deallocate(ptr, count);
+  }
+
+private:
+  std::mutex mutex_;
+  PoolAllocator<_Tp, _Block_Size> pool_;
+};
+
+/// Each thread repeatedly allocates a batch of single slots and frees it
+template <typename _Allocator>
+double throughput(_Allocator &allocator, std::size_t n_threads) {
+  const std::size_t rounds = 1 << 10;
+  const std::size_t batch = 1 << 8;
+
+  auto work = [&]() {
+    std::vector<ScalarType *> ptrs(batch);
+    for (std::size_t round = 0; round < rounds; ++round) {
+      for (auto &ptr : ptrs) {
+        ptr = allocator.allocate(1);
+        *ptr = round;
+      }
+      for (auto ptr : ptrs) {
+        allocator.deallocate(ptr, 1);
+      }
+    }
+  };
+
+  const double seconds = time_best_of(3, [&]() {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < n_threads; ++i) {
+      threads.emplace_back(work);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  });
+  return 2. * rounds * batch * n_threads / seconds;
+}
+
+/// Usage: bench_thread_cache [max_threads]
+int main(int argc, char **argv) {
+  const std::size_t max_threads =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+               : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+  std::printf("%8s %20s %20s %8s\n", "threads", "mutex (Mops/s)",
+              "cached (Mops/s)", "speedup");
+  for (std::size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    LockedAllocator<ScalarType, BlockSize> locked;
+    ThreadCachedAllocator<ScalarType, BlockSize> cached;
+
+    const double mutex_ops = throughput(locked, n_threads);
+    const double cached_ops = throughput(cached, n_threads);
+    std::printf("%8zu %20.2f %20.2f %7.2fx\n", n_threads, mutex_ops * 1e-6,
+                cached_ops * 1e-6, cached_ops / mutex_ops);
+  }
+  return 0;
+}
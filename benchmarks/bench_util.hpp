@@ -0,0 +1,38 @@
+//
+//  bench_util.hpp
+//  memorypool
+//
+
+#ifndef bench_util_h
+#define bench_util_h
+
+#include "../poolAllocator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace _fmmAllocator;
+
+/// Runs \ref func \ref repetitions times and returns the best wall time (s)
+template <typename _Function>
+double time_best_of(std::size_t repetitions, _Function &&func) {
+  double best = 0.;
+  for (std::size_t i = 0; i < repetitions; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(stop - start).count();
+    best = (i == 0) ? elapsed : std::min(best, elapsed);
+  }
+  return best;
+}
+
+/// Prints a result line: name, time and speedup over a baseline time
+inline void report(const char *name, double seconds, double baseline) {
+  std::printf("%-40s %10.3f ms %8.2fx\n", name, seconds * 1e3,
+              baseline / seconds);
+}
+
+#endif /* bench_util_h */
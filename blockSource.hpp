@@ -0,0 +1,317 @@
+/** @file blockSource.hpp
+ *  @brief Where the pools get their memory blocks from
+ *
+ *  A block source hands out (and takes back) blocks of a given size and
+ *  alignment: void *allocate(size, alignment) throws std::bad_alloc on failure,
+ *  void deallocate(ptr, size, alignment) gets the same arguments back
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef blockSource_hpp
+#define blockSource_hpp
+
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace _fmmAllocator {
+
+/// @brief Blocks from the global operator new (on top of malloc)
+class HeapBlockSource {
+public:
+  void *allocate(std::size_t size, std::size_t alignment) {
+    return ::operator new(size, std::align_val_t(alignment));
+  }
+
+  void deallocate(void *ptr, std::size_t size, std::size_t alignment) {
+    ::operator delete(ptr, size, std::align_val_t(alignment));
+  }
+};
+
+namespace detail {
+
+inline std::size_t page_size() {
+#if defined(__unix__) || defined(__APPLE__)
+  static const std::size_t size =
+      static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+#else
+  return 4 * KiB;
+#endif
+}
+
+/// @brief Faults in every page overlapping [\ref __ptr, \ref __ptr +
+/// \ref __size) for writing, leaving their contents as they are
+/// NOTE: The pages are touched by hand where MADV_POPULATE_WRITE is missing:
+/// no other thread may write to that range meanwhile
+inline void prefault(void *__ptr, std::size_t __size) {
+  if (__size == 0) {
+    return;
+  }
+  const std::uintptr_t page = page_size();
+  const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(__ptr);
+#ifdef MADV_POPULATE_WRITE
+  const std::uintptr_t start = first & ~(page - 1);
+  if (madvise(reinterpret_cast<void *>(start), first + __size - start,
+              MADV_POPULATE_WRITE) == 0) {
+    return;
+  }
+#endif
+  for (std::uintptr_t byte = first; byte < first + __size;
+       byte = (byte & ~(page - 1)) + page) {
+    volatile char *touch = reinterpret_cast<volatile char *>(byte);
+    *touch = *touch;
+  }
+}
+
+} // namespace detail
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace detail {
+
+/// @brief Maps \ref __size bytes aligned to \ref __alignment, by mapping
+/// enough to find an aligned range and unmapping the rest. Mappings are
+/// aligned to \ref __granularity anyway. Returns nullptr on failure
+inline void *map_aligned(std::size_t __size, std::size_t __alignment,
+                         std::size_t __granularity, int __prot, int __flags) {
+  const std::size_t extra = __alignment > __granularity ? __alignment : 0;
+  void *raw = mmap(nullptr, __size + extra, __prot,
+                   MAP_PRIVATE | MAP_ANONYMOUS | __flags, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  if (extra == 0) {
+    return raw;
+  }
+
+  const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(raw);
+  const std::uintptr_t aligned = (first + __alignment - 1) & ~(__alignment - 1);
+  const std::size_t head = aligned - first;
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  if (extra - head > 0) {
+    munmap(reinterpret_cast<void *>(aligned + __size), extra - head);
+  }
+  return reinterpret_cast<void *>(aligned);
+}
+
+} // namespace detail
+
+/// @brief Which pages back the mapped blocks
+enum class HugePages {
+  /// Base pages only
+  None,
+  /// madvise(MADV_HUGEPAGE): transparent huge pages where the kernel can
+  Transparent,
+  /// MAP_HUGETLB from the reserved huge pages (blocks must be a multiple of
+  /// \ref huge_page_size), else Transparent
+  Explicit,
+};
+
+/// @brief Blocks mapped straight from the kernel
+/// Huge pages cut the TLB misses of large pools. With \ref _Populate the pages
+/// are faulted in when the block is mapped instead of on first touch.
+template <HugePages _Huge_Pages = HugePages::Transparent,
+          bool _Populate = false>
+class MmapBlockSource {
+public:
+  /// Assumed size of a huge page (the x86-64 and aarch64 default)
+  static constexpr std::size_t huge_page_size = 2 * detail::MiB;
+
+  void *allocate(std::size_t size, std::size_t alignment) {
+#ifdef MAP_HUGETLB
+    if (_Huge_Pages == HugePages::Explicit && size % huge_page_size == 0) {
+      // Huge page mappings are aligned to the huge page size
+      const int flags = MAP_HUGETLB | (_Populate ? MAP_POPULATE : 0);
+      if (void *ptr = detail::map_aligned(size, alignment, huge_page_size,
+                                          PROT_READ | PROT_WRITE, flags)) {
+        return ptr;
+      }
+      // No huge pages reserved (see /proc/sys/vm/nr_hugepages)
+    }
+#endif
+    void *ptr = detail::map_aligned(size, alignment, detail::page_size(),
+                                    PROT_READ | PROT_WRITE, 0);
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    // NOTE: Must come before the first touch of the pages
+    if (_Huge_Pages != HugePages::None) {
+      madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#endif
+    if (_Populate) {
+      detail::prefault(ptr, size);
+    }
+    return ptr;
+  }
+
+  void deallocate(void *ptr, std::size_t size, std::size_t) {
+    munmap(ptr, size);
+  }
+};
+
+/// @brief Blocks committed on demand from a single range of \ref _Reserve_Size
+/// bytes of address space, reserved (PROT_NONE) once
+/// Pool memory stays contiguous, and whether a pointer belongs to the pool is a
+/// range check (see \ref contains). A deallocated block is decommitted but its
+/// addresses stay reserved: the decommitted ranges are merged with their
+/// neighbours and split again by the next allocations (first fit, lowest
+/// address first). The source throws std::bad_alloc once no range is left.
+/// NOTE: Every allocation must have the same alignment, and a multiple of it
+/// as its size
+template <std::size_t _Reserve_Size,
+          HugePages _Huge_Pages = HugePages::None>
+class ReservedBlockSource {
+public:
+  ReservedBlockSource() = default;
+
+  ReservedBlockSource(const ReservedBlockSource &) = delete;
+  ReservedBlockSource &operator=(const ReservedBlockSource &) = delete;
+
+  ~ReservedBlockSource() {
+    if (first_ != nullptr) {
+      munmap(first_, _Reserve_Size);
+    }
+  }
+
+  void *allocate(std::size_t size, std::size_t alignment) {
+    if (unlikely(first_ == nullptr)) {
+      reserve(alignment);
+    }
+
+    char *block = nullptr;
+    for (auto range = free_.begin(); range != free_.end(); ++range) {
+      if (range->second >= size) {
+        block = range->first;
+        range->first += size;
+        range->second -= size;
+        if (range->second == 0) {
+          free_.erase(range);
+        }
+        break;
+      }
+    }
+    if (block == nullptr) {
+      if (static_cast<std::size_t>(last_ - next_) < size) {
+        throw std::bad_alloc();
+      }
+      block = next_;
+      next_ += size;
+    }
+
+    if (mprotect(block, size, PROT_READ | PROT_WRITE) != 0) {
+      give_back(block, size);
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (_Huge_Pages != HugePages::None) {
+      madvise(block, size, MADV_HUGEPAGE);
+    }
+#endif
+    return block;
+  }
+
+  void deallocate(void *ptr, std::size_t size, std::size_t) {
+    madvise(ptr, size, MADV_DONTNEED);
+    mprotect(ptr, size, PROT_NONE);
+    give_back(static_cast<char *>(ptr), size);
+  }
+
+  /// @brief Whether \ref ptr lies in a committed part of the reserved range
+  bool contains(const void *ptr) const {
+    const char *byte = static_cast<const char *>(ptr);
+    if (first_ == nullptr || byte < first_ || byte >= next_) {
+      return false;
+    }
+    // The decommitted range starting last at or before ptr
+    auto range = std::upper_bound(
+        free_.begin(), free_.end(), byte,
+        [](const char *__byte, const std::pair<char *, std::size_t> &__range) {
+          return __byte < __range.first;
+        });
+    return range == free_.begin() ||
+           byte >= std::prev(range)->first + std::prev(range)->second;
+  }
+
+  /// @brief The reserved range
+  void *begin() const { return first_; }
+  void *end() const { return last_; }
+
+private:
+  /// @brief Reserves the address range (aligned as the blocks)
+  void reserve(std::size_t alignment) {
+    first_ = static_cast<char *>(
+        detail::map_aligned(_Reserve_Size, alignment, detail::page_size(),
+                            PROT_NONE, MAP_NORESERVE));
+    if (first_ == nullptr) {
+      throw std::bad_alloc();
+    }
+    next_ = first_;
+    last_ = first_ + _Reserve_Size;
+  }
+
+  /// @brief Adds the \ref size bytes at \ref ptr to the decommitted ranges,
+  /// merged with the ones right before and after (and with the never
+  /// committed part)
+  void give_back(char *ptr, std::size_t size) {
+    auto range = std::lower_bound(
+        free_.begin(), free_.end(), ptr,
+        [](const std::pair<char *, std::size_t> &__range, const char *__ptr) {
+          return __range.first < __ptr;
+        });
+    if (range != free_.begin() &&
+        std::prev(range)->first + std::prev(range)->second == ptr) {
+      range = std::prev(range);
+      range->second += size;
+    } else {
+      range = free_.emplace(range, ptr, size);
+    }
+    auto next = std::next(range);
+    if (next != free_.end() && range->first + range->second == next->first) {
+      range->second += next->second;
+      free_.erase(next);
+    }
+    if (range->first + range->second == next_) {
+      next_ = range->first;
+      free_.erase(range);
+    }
+  }
+
+  /// The reserved range and the start of the never committed part
+  char *first_ = nullptr;
+  char *next_ = nullptr;
+  char *last_ = nullptr;
+
+  /// Decommitted ranges (and their size), by address
+  std::vector<std::pair<char *, std::size_t>> free_;
+};
+
+/// @brief Where the allocations too large for a block go: page-aligned
+/// mappings, handed back to the kernel as soon as they are deallocated
+using LargeBlockSource = MmapBlockSource<HugePages::None>;
+
+#else
+
+using LargeBlockSource = HeapBlockSource;
+
+#endif
+
+} // namespace _fmmAllocator
+#endif /* blockSource_hpp */
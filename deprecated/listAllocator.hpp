@@ -90,6 +90,17 @@ public:
     pool_->deallocate_pointer(ptr);
   }
 
+  /// @brief Lists may only exchange nodes (e.g. splice) if they share the pool
+  template <typename _Up>
+  bool operator==(const ListAllocator<_Up, __Pool_Allocator> &__other) const {
+    return pool_ == __other.pool_;
+  }
+
+  template <typename _Up>
+  bool operator!=(const ListAllocator<_Up, __Pool_Allocator> &__other) const {
+    return pool_ != __other.pool_;
+  }
+
   /// @brief Constant pointer to the pool that does the memory management
   /// NOTE: A list using this allocator may NEVER own a pool, hence this shall
   /// never take ownership
@@ -0,0 +1,220 @@
+/** @file monotonicArena.hpp
+ *  @brief Bump-pointer arena, emptied all at once
+ *
+ *  For work that allocates many objects and frees them all together (a
+ *  request, a frame...): allocating bumps a pointer through the current
+ *  block, deallocating does nothing, and \ref MonotonicArena::reset rewinds
+ *  every block at once, keeping them for the next round
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef monotonicArena_hpp
+#define monotonicArena_hpp
+
+#include "blockSource.hpp"
+#include "generalAllocator.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace _fmmAllocator {
+
+/// @brief
+/// The MonotonicArena hands out memory by bumping a pointer through blocks of
+/// \ref _Block_Size bytes, taken from a \ref _Block_Source. Nothing is freed
+/// until \ref reset, which rewinds to the first block in O(1): the blocks are
+/// kept and refilled in the same order. Requests too large for a block get
+/// their own mapping (see \ref LargeBlockSource), given back on \ref reset.
+///
+/// NOTE: Not thread-safe: an arena belongs to the thread that uses it
+template <std::size_t _Block_Size, class _Block_Source = HeapBlockSource>
+class MonotonicArena {
+public:
+  using block_source = _Block_Source;
+
+  MonotonicArena() = default;
+
+  MonotonicArena(const MonotonicArena &) = delete;
+  MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+  ~MonotonicArena() { release(); }
+
+  /// @brief Allocates \ref bytes aligned to \ref alignment (a power of two)
+  DEQUE_INLINE void *allocate(std::size_t bytes, std::size_t alignment) {
+    const std::uintptr_t ptr = (next_ + alignment - 1) & ~(alignment - 1);
+    // NOTE: No block yet: next_ and end_ are both 0
+    if (likely(ptr + bytes <= end_ && ptr != 0)) {
+      next_ = ptr + bytes;
+      return reinterpret_cast<void *>(ptr);
+    }
+    return allocate_slow(bytes, alignment);
+  }
+
+  /// @brief Does nothing: the memory comes back on \ref reset
+  void deallocate(void *, std::size_t) {}
+
+  /// @brief Frees everything allocated so far. The blocks are kept for reuse,
+  /// the large allocations are given back
+  void reset() {
+    release_large();
+    used_ = 0;
+    next_ = end_ = 0;
+  }
+
+  /// @brief Same, giving every block back to the source
+  void release() {
+    reset();
+    for (char *block : blocks_) {
+      source_.deallocate(block, _Block_Size, _Block_Size);
+    }
+    blocks_.clear();
+  }
+
+  /// @brief Number of blocks held, in use or not
+  std::size_t blocks() const { return blocks_.size(); }
+
+  /// @brief Number of blocks allocated from since the last \ref reset
+  std::size_t blocks_in_use() const { return used_; }
+
+  /// @brief Where the blocks come from
+  block_source &get_block_source() { return source_; }
+
+private:
+  struct Large {
+    void *ptr;
+    std::size_t size;
+    std::size_t alignment;
+  };
+
+  /// @brief Moves on to the next block (or a large allocation of its own)
+  void *allocate_slow(std::size_t bytes, std::size_t alignment) {
+    if (unlikely(bytes + alignment > _Block_Size)) {
+      return allocate_large(bytes, alignment);
+    }
+    if (used_ == blocks_.size()) {
+      POOL_EVENT(new_block, 1)
+      blocks_.push_back(
+          static_cast<char *>(source_.allocate(_Block_Size, _Block_Size)));
+    }
+    const std::uintptr_t block =
+        reinterpret_cast<std::uintptr_t>(blocks_[used_++]);
+    const std::uintptr_t ptr = (block + alignment - 1) & ~(alignment - 1);
+    next_ = ptr + bytes;
+    end_ = block + _Block_Size;
+    return reinterpret_cast<void *>(ptr);
+  }
+
+  void *allocate_large(std::size_t bytes, std::size_t alignment) {
+    POOL_EVENT(large_map, 1)
+    const std::size_t page = detail::page_size();
+    Large large{nullptr, (bytes + page - 1) / page * page,
+                std::max(alignment, page)};
+    large.ptr = large_source_.allocate(large.size, large.alignment);
+    large_.push_back(large);
+    return large.ptr;
+  }
+
+  void release_large() {
+    POOL_EVENT(large_unmap, large_.size())
+    for (const Large &large : large_) {
+      large_source_.deallocate(large.ptr, large.size, large.alignment);
+    }
+    large_.clear();
+  }
+
+  /// The free range of the current block
+  std::uintptr_t next_ = 0;
+  std::uintptr_t end_ = 0;
+
+  /// Blocks in the order they are filled, the first \ref used_ in use
+  std::vector<char *> blocks_;
+  std::size_t used_ = 0;
+
+  std::vector<Large> large_;
+
+  _Block_Source source_;
+  LargeBlockSource large_source_;
+};
+
+/// @brief
+/// STL compatible handle on a shared \ref MonotonicArena, to swap in for a
+/// \ref PoolAllocator (or \ref ArenaAllocator) where everything is freed at
+/// once. Copies, rebound copies included, share the arena and compare equal;
+/// the arena goes away with the last handle.
+///
+/// NOTE: Containers must be cleared (or destroyed) before the arena is
+/// \ref reset. Moves copy, so that a moved-from container may still allocate
+template <typename _Tp, std::size_t _Block_Size,
+          class _Block_Source = HeapBlockSource>
+class MonotonicAllocator : public GeneralAllocator<_Tp> {
+public:
+  using value_type = _Tp;
+  using reference = _Tp &;
+  using const_reference = const _Tp &;
+  using pointer = _Tp *;
+  using const_pointer = const _Tp *;
+
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  using arena_type = MonotonicArena<_Block_Size, _Block_Source>;
+
+  template <typename _Up> struct rebind {
+    typedef MonotonicAllocator<_Up, _Block_Size, _Block_Source> other;
+  };
+
+  /// @brief Default ctor: creates a new arena
+  MonotonicAllocator() : arena_(std::make_shared<arena_type>()) {}
+
+  /// @brief Handle on \ref arena
+  explicit MonotonicAllocator(std::shared_ptr<arena_type> arena)
+      : arena_(std::move(arena)) {}
+
+  MonotonicAllocator(const MonotonicAllocator &) = default;
+  MonotonicAllocator &operator=(const MonotonicAllocator &) = default;
+
+  template <typename _Up>
+  MonotonicAllocator(
+      const MonotonicAllocator<_Up, _Block_Size, _Block_Source> &other)
+      : arena_(other.arena_) {}
+
+  /// @brief Allocates memory
+  pointer allocate(std::size_t count, const void * = nullptr) {
+    return static_cast<pointer>(
+        arena_->allocate(count * sizeof(_Tp), alignof(_Tp)));
+  }
+
+  /// @brief Does nothing (see \ref MonotonicArena::reset)
+  void deallocate(pointer, std::size_t) {}
+
+  const std::shared_ptr<arena_type> &arena() const { return arena_; }
+
+  template <typename _Up>
+  bool operator==(const MonotonicAllocator<_Up, _Block_Size, _Block_Source>
+                      &other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <typename _Up>
+  bool operator!=(const MonotonicAllocator<_Up, _Block_Size, _Block_Source>
+                      &other) const {
+    return arena_ != other.arena_;
+  }
+
+private:
+  template <typename _Up, std::size_t, class> friend class MonotonicAllocator;
+
+  std::shared_ptr<arena_type> arena_;
+};
+
+} // namespace _fmmAllocator
+#endif /* monotonicArena_hpp */
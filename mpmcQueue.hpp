@@ -0,0 +1,197 @@
+/** @file mpmcQueue.hpp
+ *  @brief Bounded lock-free multiple producer, multiple consumer queue
+ *
+ *  Preallocated ring of sequence-numbered cells (after D. Vyukov's bounded
+ *  MPMC queue)
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef mpmcQueue_h
+#define mpmcQueue_h
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+/// @brief A bounded, preallocated, lock-free FIFO queue
+/// Every cell carries a sequence number telling producers and consumers whose
+/// turn it is: a producer at position pos may fill the cell once its sequence
+/// equals pos, a consumer may empty it once its sequence equals pos + 1. The
+/// only shared writes are a CAS on the head or tail position and the cell's
+/// sequence store.
+template <typename _Tp> class MPMCQueue {
+public:
+  typedef _Tp value_type;
+
+  /// @brief Creates a queue holding up to \ref capacity elements (rounded up to
+  /// a power of 2)
+  explicit MPMCQueue(std::size_t capacity)
+      : mask_(round_up(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// NOTE: No other thread may use the queue anymore
+  ~MPMCQueue() {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    for (std::size_t pos = head_.load(std::memory_order_relaxed); pos != tail;
+         ++pos) {
+      cells_[pos & mask_].address()->~value_type();
+    }
+  }
+
+  MPMCQueue(const MPMCQueue &) = delete;
+  MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+  /// @brief Constructs an element at the tail. Returns false if the queue is
+  /// full
+  template <class... Args> bool try_emplace(Args &&... args) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = cells_[pos & mask_];
+      const std::size_t sequence =
+          cell.sequence_.load(std::memory_order_acquire);
+      const std::ptrdiff_t turn = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (turn == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          new (cell.address()) value_type(std::forward<Args>(args)...);
+          cell.sequence_.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (turn < 0) {
+        return false; // the consumers did not empty this cell yet
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_push(const value_type &value) { return try_emplace(value); }
+  bool try_push(value_type &&value) { return try_emplace(std::move(value)); }
+
+  /// @brief Moves the head element into \ref value. Returns false if the queue
+  /// is empty
+  bool try_pop(value_type &value) {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    Cell *cell = claim(pos);
+    if (cell == nullptr) {
+      return false;
+    }
+    value = std::move(*cell->address());
+    vacate(*cell, pos);
+    return true;
+  }
+
+  /// @brief Blocking push: waits (spinning, then yielding) for a free cell
+  template <class... Args> void push(Args &&... args) {
+    for (std::size_t spins = 0; !try_emplace(std::forward<Args>(args)...);
+         ++spins) {
+      backoff(spins);
+    }
+  }
+
+  /// @brief Blocking pop: waits (spinning, then yielding) for an element
+  /// NOTE: The element is moved out of its cell, \ref value_type need not be
+  /// default constructible
+  value_type pop() {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (std::size_t spins = 0; (cell = claim(pos)) == nullptr; ++spins) {
+      backoff(spins);
+      pos = head_.load(std::memory_order_relaxed);
+    }
+    return take(*cell, pos);
+  }
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  /// NOTE: Only a snapshot, other threads may change it right away
+  std::size_t size_approx() const {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool empty() const { return size_approx() == 0; }
+
+private:
+  /// Assumed size of a cache line (keeps the positions apart)
+  static constexpr std::size_t cache_line = 64;
+
+  struct Cell {
+    value_type *address() { return reinterpret_cast<value_type *>(&storage_); }
+
+    std::atomic<std::size_t> sequence_;
+    typename std::aligned_storage<sizeof(value_type),
+                                  alignof(value_type)>::type storage_;
+  };
+
+  /// @brief Claims the head cell, from the head position \ref pos (updated to
+  /// the position claimed). Returns nullptr if the queue is empty
+  /// NOTE: The element of the claimed cell must then be moved out and the cell
+  /// vacated (see \ref vacate)
+  Cell *claim(std::size_t &pos) {
+    for (;;) {
+      Cell &cell = cells_[pos & mask_];
+      const std::size_t sequence =
+          cell.sequence_.load(std::memory_order_acquire);
+      const std::ptrdiff_t turn =
+          static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (turn == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          return &cell;
+        }
+      } else if (turn < 0) {
+        return nullptr; // the producers did not fill this cell yet
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief Moves the element out of the \ref cell claimed at \ref pos
+  value_type take(Cell &cell, std::size_t pos) {
+    value_type value(std::move(*cell.address()));
+    vacate(cell, pos);
+    return value;
+  }
+
+  /// @brief Destroys the (moved from) element of the \ref cell claimed at
+  /// \ref pos and hands the cell over to the producers
+  void vacate(Cell &cell, std::size_t pos) {
+    cell.address()->~value_type();
+    cell.sequence_.store(pos + mask_ + 1, std::memory_order_release);
+  }
+
+  static std::size_t round_up(std::size_t capacity) {
+    std::size_t power = 2;
+    while (power < capacity) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  static void backoff(std::size_t spins) {
+    if (spins > 64) {
+      std::this_thread::yield();
+    }
+  }
+
+  const std::size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+
+  alignas(cache_line) std::atomic<std::size_t> tail_{0};
+  alignas(cache_line) std::atomic<std::size_t> head_{0};
+};
+
+#endif /* mpmcQueue_h */
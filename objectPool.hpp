@@ -0,0 +1,218 @@
+/** @file objectPool.hpp
+ *  @brief Pool of recycled, constructed objects
+ *
+ *  Objects live in the blocks of a PoolAllocator and stay constructed when
+ *  they are given back: the next acquire hands them out again as they are.
+ *  Free objects are cached per thread (as in threadCache.hpp), so that
+ *  acquiring and releasing only take a lock once per half magazine
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef objectPool_hpp
+#define objectPool_hpp
+
+#include "poolAllocator.hpp"
+#include "threadCache.hpp"
+#include "util.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace _fmmAllocator {
+
+/// @brief
+/// The ObjectPool hands out objects of type \ref _Tp, constructed once in the
+/// blocks of a \ref PoolAllocator and recycled from then on. A released
+/// object goes to a magazine owned by the releasing thread, which flushes
+/// (and refills) \ref _Magazine_Size / 2 objects at a time to (and from) the
+/// free objects of the pool, under its mutex.
+///
+/// Objects come as a std::unique_ptr whose deleter is a single pointer to
+/// the shared state of the pool.
+///
+/// NOTE: The shared state lives on until the pool and every object acquired
+/// from it are gone. Then the free objects are destroyed, the ones cached by
+/// every thread included
+template <typename _Tp, std::size_t _Block_Size,
+          std::size_t _Magazine_Size = 64>
+class ObjectPool {
+  struct Central;
+
+public:
+  using value_type = _Tp;
+  using pool_allocator = PoolAllocator<_Tp, _Block_Size>;
+
+  /// @brief Gives the object back to its pool
+  class Deleter {
+  public:
+    Deleter() = default;
+
+    void operator()(_Tp *object) const { release(central_, object); }
+
+  private:
+    friend class ObjectPool;
+
+    explicit Deleter(Central *central) : central_(central) {}
+
+    Central *central_ = nullptr;
+  };
+
+  using handle = std::unique_ptr<_Tp, Deleter>;
+
+  /// @brief Default ctor: no object is created until the first acquire
+  ObjectPool() : central_(new Central()) {}
+
+  /// @brief Creates \ref count objects up front, constructed from \ref args
+  template <typename... _Args>
+  explicit ObjectPool(std::size_t count, const _Args &... args)
+      : ObjectPool() {
+    for (std::size_t i = 0; i < count; ++i) {
+      _Tp *object = central_->create(args...);
+      std::lock_guard<std::mutex> lock{central_->mutex_};
+      central_->free_.push_back(object);
+    }
+  }
+
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  /// @brief The objects still out keep the shared state alive
+  ~ObjectPool() { Central::unref(central_); }
+
+  /// @brief A free object, as it was given back. If there is none, a new one
+  /// constructed from \ref args
+  template <typename... _Args> handle acquire(_Args &&... args) {
+    Magazine &magazine = central_->magazines_.local(*central_);
+    if (unlikely(magazine.size_ == 0) &&
+        !magazine.refill(_Magazine_Size / 2)) {
+      _Tp *object = central_->create(std::forward<_Args>(args)...);
+      central_->refs_.fetch_add(1, std::memory_order_relaxed);
+      return handle(object, Deleter(central_));
+    }
+    central_->refs_.fetch_add(1, std::memory_order_relaxed);
+    return handle(magazine.objects_[--magazine.size_], Deleter(central_));
+  }
+
+  /// @brief Returns the calling thread's cached objects to the pool
+  void flush() { central_->magazines_.retire_local(); }
+
+  /// @brief Number of objects constructed so far
+  std::size_t created() const {
+    std::lock_guard<std::mutex> lock{central_->mutex_};
+    return central_->created_;
+  }
+
+private:
+  struct Magazine;
+
+  /// @brief The objects and the free ones, shared with the deleters
+  struct Central {
+    ~Central() {
+      magazines_.close();
+      for (_Tp *object : free_) {
+        object->~_Tp();
+        pool_.deallocate(object, 1);
+      }
+    }
+
+    /// Drops a reference: the pool's or an object's. The last one destroys
+    /// the shared state
+    static void unref(Central *central) {
+      if (central->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete central;
+      }
+    }
+
+    template <typename... _Args> _Tp *create(_Args &&... args) {
+      _Tp *object;
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        object = pool_.allocate(1);
+        ++created_;
+      }
+      try {
+        new (static_cast<void *>(object)) _Tp(std::forward<_Args>(args)...);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        pool_.deallocate(object, 1);
+        --created_;
+        throw;
+      }
+      return object;
+    }
+
+    std::mutex mutex_;
+    pool_allocator pool_;
+
+    /// Free objects, still constructed
+    std::vector<_Tp *> free_;
+    std::size_t created_ = 0;
+
+    /// NOTE: Goes before the pool, along with the objects cached by every
+    /// thread
+    detail::MagazineDepot<Magazine> magazines_;
+
+    /// The pool and the objects acquired from it
+    alignas(detail::cache_line) std::atomic<std::size_t> refs_{1};
+  };
+
+  /// @brief A bounded stack of free objects owned by one thread
+  struct Magazine {
+    explicit Magazine(Central &__central) : central_(&__central) {}
+
+    /// Destroys the objects left, as the pool goes away
+    ~Magazine() {
+      for (std::size_t i = 0; i < size_; ++i) {
+        objects_[i]->~_Tp();
+      }
+    }
+
+    /// Returns every cached object to the pool
+    void drain() { flush(size_); }
+
+    /// Returns the \ref count most recently cached objects to the pool
+    void flush(std::size_t count) {
+      std::lock_guard<std::mutex> lock{central_->mutex_};
+      for (; count > 0; --count) {
+        central_->free_.push_back(objects_[--size_]);
+      }
+    }
+
+    /// Takes up to \ref count free objects from the pool. Returns whether
+    /// there were any
+    bool refill(std::size_t count) {
+      std::lock_guard<std::mutex> lock{central_->mutex_};
+      std::vector<_Tp *> &free = central_->free_;
+      for (; count > 0 && !free.empty(); --count) {
+        objects_[size_++] = free.back();
+        free.pop_back();
+      }
+      return size_ > 0;
+    }
+
+    Central *central_;
+    std::size_t size_ = 0;
+    _Tp *objects_[_Magazine_Size];
+  };
+
+  /// @brief Caches \ref object in the calling thread's magazine
+  static void release(Central *central, _Tp *object) {
+    Magazine &magazine = central->magazines_.local(*central);
+    if (unlikely(magazine.size_ == _Magazine_Size)) {
+      magazine.flush(_Magazine_Size / 2);
+    }
+    magazine.objects_[magazine.size_++] = object;
+    Central::unref(central);
+  }
+
+  Central *central_;
+};
+
+} // namespace _fmmAllocator
+#endif /* objectPool_hpp */
@@ -10,23 +10,161 @@
 #ifndef block_manager_h
 #define block_manager_h
 
+#include "allocationTrace.hpp"
+#include "blockSource.hpp"
 #include "generalAllocator.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
-#include <forward_list>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory> //std::adressof
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace _fmmAllocator {
 
+/// @brief How a block is given back to the system
+enum class BlockRelease {
+  /// The block is deallocated
+  Delete,
+  /// madvise(MADV_DONTNEED): the block stays mapped but its pages are dropped
+  DontNeed,
+  /// madvise(MADV_FREE): the pages are only dropped under memory pressure
+  Free,
+};
+
+/// @brief When a pool gives its empty blocks back to the system
+struct TrimPolicy {
+  /// Empty blocks kept for reuse (by default, all of them)
+  std::size_t spare_blocks = std::numeric_limits<std::size_t>::max();
+
+  /// An empty block past the spare ones is released once it stayed empty
+  /// that long (checked whenever another block becomes empty, and by trim)
+  /// NOTE: The blocks of single slots only become empty once folded back (see
+  /// PoolAllocator::recycle_slots): a pool that does not recycle its slots
+  /// should call PoolAllocator::trim now and then for the policy to apply
+  std::chrono::steady_clock::duration idle_time =
+      std::chrono::steady_clock::duration::zero();
+
+  BlockRelease release = BlockRelease::Delete;
+
+  /// Freed allocations too large for a block kept for reuse (each one is
+  /// reused by an allocation of the same size class only)
+  std::size_t spare_large = 8;
+};
+
+/// @brief Growth policies: how many blocks a pool takes at once from its block
+/// source (as one contiguous segment), given how many blocks it holds already.
+/// Any class with a member std::size_t blocks(std::size_t held) will do
+
+/// @brief One block at a time
+struct FixedGrowth {
+  std::size_t blocks(std::size_t) const { return 1; }
+};
+
+/// @brief As many blocks as the pool holds already (its size doubles), at
+/// least one and at most \ref _Max_Blocks
+/// A small \ref _Block_Size keeps small pools small, while large pools still
+/// take few, large segments from the block source
+template <std::size_t _Max_Blocks = 64> struct GeometricGrowth {
+  static_assert(_Max_Blocks >= 1, "A pool must grow by at least one block");
+
+  std::size_t blocks(std::size_t held) const {
+    return held == 0 ? 1 : held < _Max_Blocks ? held : _Max_Blocks;
+  }
+};
+
+/// @brief A snapshot of the state of a pool (see PoolAllocator::stats)
+/// The counters are only kept when POOL_STATS_ENABLED is defined (they stay 0
+/// otherwise); the free memory is measured on the spot
+struct PoolStats {
+  /// Counters
+  std::size_t allocations = 0;
+  std::size_t frees = 0;
+  /// Bytes requested by the allocations not freed yet
+  std::size_t bytes_in_use = 0;
+  /// Blocks taken from the block source (or faulted back in) and given back
+  std::size_t blocks_allocated = 0;
+  std::size_t blocks_freed = 0;
+  /// Searches of the free chunks, chunks visited by the first-fit scans and
+  /// the longest scan
+  std::size_t searches = 0;
+  std::size_t scanned = 0;
+  std::size_t max_scan = 0;
+  std::size_t recycles = 0;
+
+  /// Bytes of the resident blocks and of the large allocations (the large
+  /// allocations in use are only known to the counters)
+  std::size_t bytes_reserved = 0;
+  /// Bytes of the free chunks (headers included), single slots and empty
+  /// blocks
+  std::size_t bytes_free = 0;
+  /// Number of free chunks (see PoolAllocator::free_chunks)
+  std::size_t free_chunks = 0;
+  /// 1 - largest free chunk / bytes_free: 0 when all the free memory is one
+  /// chunk, close to 1 when it is scattered in small pieces
+  double fragmentation = 0.;
+
+  /// @brief Average number of chunks visited per search
+  double average_scan() const {
+    return searches > 0 ? static_cast<double>(scanned) / searches : 0.;
+  }
+};
+
 /// @brief
 /// The PoolAllocator manages the allocation (through memory blocks),
 /// bookkeeping of used memory and the recycling of memory for a fixed data type
 /// \ref T
-template <typename _Tp, std::size_t _Block_Size, bool _Recycle_Slots = false>
+///
+/// Free chunks are segregated in \ref _Size_Classes power-of-two bins: bin i
+/// holds the chunks with size in [2^i, 2^(i+1)) and the last bin is unbounded.
+/// A single size class degenerates into a first-fit scan of all free chunks.
+///
+/// A pool has no owner by default: the caller serializes every (de)allocation.
+/// Once handed to a thread (see \ref set_owner), only the owner may allocate,
+/// but any thread may deallocate. Frees from other threads are pushed onto
+/// lock-free lists that the owner drains lazily.
+///
+/// When \ref _Recycle_Slots is set, a freed chunk is merged right away with the
+/// free chunks physically next to it: every block starts with a bitmap marking
+/// the first and the last slot of each free chunk (its boundary tags), and the
+/// last slot of a free chunk repeats its size. Single slots are only folded
+/// back into chunks by an explicit \ref recycle_slots.
+///
+/// A block whose slots are all free again (a single free chunk spanning it)
+/// leaves the free lists. It is reused before any new block is allocated, or
+/// given back to the system according to the \ref TrimPolicy (see also
+/// \ref trim).
+///
+/// Blocks come from a \ref _Block_Source (see blockSource.hpp), aligned to
+/// their size: the block (and its header) of any pointer is found by masking
+/// the address. The \ref _Growth policy sets how many blocks are taken at
+/// once: a segment of contiguous blocks, each one with its own header, given
+/// back once all of its blocks were released.
+///
+/// Slots are aligned to \ref _Tp (page alignment and beyond included, given
+/// blocks of a few such slots), and to \ref _Slot_Align if stricter. Set it
+/// to detail::cache_line to put every single element, and every run of
+/// elements, on cache lines of its own: objects used by different threads
+/// then never share a line (at the price of the padding).
+template <typename _Tp, std::size_t _Block_Size, bool _Recycle_Slots = false,
+          std::size_t _Size_Classes = detail::size_classes(_Block_Size),
+          class _Block_Source = HeapBlockSource,
+          class _Growth = FixedGrowth, std::size_t _Slot_Align = 1>
 class PoolAllocator : public GeneralAllocator<_Tp> {
 public:
   using value_type = _Tp;
@@ -38,43 +176,77 @@ public:
   typedef std::true_type propagate_on_container_move_assignment;
   typedef std::true_type is_always_equal;
 
-  using memory_chunk = detail::MemoryChunk<value_type>;
-  using pool_allocator = PoolAllocator<_Tp, _Block_Size, _Recycle_Slots>;
-  using list_allocator = ListAllocator<memory_chunk, pool_allocator>;
+  using memory_chunk = detail::MemoryChunk<value_type, _Slot_Align>;
+  using pool_allocator =
+      PoolAllocator<_Tp, _Block_Size, _Recycle_Slots, _Size_Classes,
+                    _Block_Source, _Growth, _Slot_Align>;
+  using block_source = _Block_Source;
+  using growth_policy_type = _Growth;
+
+  using slot = typename memory_chunk::Slot;
+
+private:
+  /// Boundary tags of the free chunks (only kept when recycling slots)
+  using boundary_tags =
+      detail::BoundaryTags<_Recycle_Slots
+                               ? _Block_Size / memory_chunk::alignement()
+                               : 0>;
+
+  /// @brief Metadata stored at the start of every block
+  /// NOTE: Derives from the tags so that no tags take no room
+  struct BlockHeader : boundary_tags {
+    boundary_tags &tags() { return *this; }
+
+    /// The first block of the segment holding this block
+    BlockHeader *segment_;
+
+    /// Kept by the first block of a segment only: its entry in \ref blocks_,
+    /// its number of blocks and how many of them were released
+    std::list<void *>::iterator self_;
+    std::size_t n_blocks_;
+    std::size_t n_released_;
+  };
+
+public:
+  /// @brief Number of slots taken by the header of every block
+  static constexpr std::size_t header_slots() {
+    return (sizeof(BlockHeader) + memory_chunk::alignement() - 1) /
+           memory_chunk::alignement();
+  }
 
   static constexpr std::size_t slots_in_block() {
-    return _Block_Size / memory_chunk::alignement() - memory_chunk::padding();
+    return _Block_Size / memory_chunk::alignement() - header_slots() -
+           memory_chunk::padding();
+  };
+
+  /// @brief Maximum number of elements a single allocation may request
+  static constexpr std::size_t max_count() {
+    return slots_in_block() * memory_chunk::alignement() / sizeof(_Tp);
   };
 
+  /// NOTE: A rebound pool is a new, empty pool: containers that rebind (node
+  /// based ones) should use an \ref ArenaAllocator (see poolArena.hpp)
   template <typename _Up> struct rebind {
-    typedef PoolAllocator<_Up, _Block_Size> other;
+    typedef PoolAllocator<_Up, _Block_Size, _Recycle_Slots, _Size_Classes,
+                          _Block_Source, _Growth, _Slot_Align>
+        other;
   };
 
   /// @brief Default ctor
-  explicit PoolAllocator() : chunks_(list_allocator(this)) {
+  explicit PoolAllocator() {
     DEQUE_PRINT("POOL: Standard Allocator called for\t\t" << typeid(_Tp).name())
-
-    //	chunks_ptr_ = ::operator new(1028);
-    //	DEBUG_PRINT("Original pointer:\t\t" << chunks_ptr_)
-    //
-    //	chunks_.emplace_front(chunks_ptr_, 3);
-    //	auto front = chunks_.begin();
-    //	DEBUG_PRINT("Location in STL:\t\t" << std::addressof(*front))
-    //
-    //	chunks_.erase(front);
-    //	DEBUG_PRINT("New pointer dealloc:\t" << chunks_ptr_)
   }
 
   /// @brief Default dtor
   ~PoolAllocator() {
-    // Clears free chunks list
-    // NOTE: This needs to come before the deallocation of the allocated blocks
-    // since the contents of the list are stored in these blocks
-    chunks_.clear();
+    release_large(0);
 
-    // Deallocate all allocated memory blocks
+    // Deallocate all allocated segments (the free lists live inside them)
     for (auto &block : blocks_) {
-      ::operator delete(block);
+      source_.deallocate(block,
+                         static_cast<BlockHeader *>(block)->n_blocks_ *
+                             _Block_Size,
+                         _Block_Size);
     }
   }
 
@@ -86,158 +258,1243 @@ public:
   explicit PoolAllocator(PoolAllocator<_Up, __Block_Size> &&pool_) = delete;
 
   /// @brief Allocates memory
+  /// NOTE: Allocations of more than \ref max_count elements get their own
+  /// mapping, page-aligned at least (see \ref LargeBlockSource)
   pointer allocate(std::size_t count, void * = nullptr) {
-    if (likely(count <= slots_in_block())) {
-      return this->allocate_impl(count);
-    } else {
-#ifndef NDEBUG
+    POOL_STAT(++counters_.allocations)
+    POOL_STAT(counters_.bytes_in_use += count * sizeof(_Tp))
+    pointer ptr;
+    if (unlikely(count > max_count())) {
       if (unlikely(count > this->max_size())) {
         throw std::length_error("Requested too many allocations");
       }
-      throw std::length_error("_Block_Size can't fit requested allocation!");
-#else
-      return ::new _Tp[count];
-#endif
+      ptr = this->allocate_large(count);
+    } else if (likely(count == 1)) {
+      ptr = this->allocate_slot();
+    } else {
+      ptr = this->allocate_impl(memory_chunk::units(count));
     }
+    POOL_TRACE(trace_.record(TraceOp::Allocate, ptr, count))
+    return ptr;
   }
 
   /// @brief Deallocates memory
   void deallocate(pointer ptr, std::size_t count) {
-#ifdef NDEBUG
-    if (likely(sizeof(_Tp) * count <= _Block_Size)) {
-#endif
-      chunks_ptr_ = static_cast<void *>(ptr);
-      chunks_.emplace_front(chunks_ptr_, count);
-#ifdef NDEBUG
+    POOL_TRACE(trace_.record(TraceOp::Deallocate, ptr, count))
+    if (unlikely(!owned_by_caller())) {
+      remote_deallocate(ptr, count);
+      return;
+    }
+    POOL_STAT(++counters_.frees)
+    POOL_STAT(counters_.bytes_in_use -= count * sizeof(_Tp))
+    if (unlikely(count > max_count())) {
+      deallocate_large(ptr, count);
+    } else if (likely(count == 1)) {
+      deallocate_slot(ptr);
     } else {
-      ::delete[] ptr;
+      push_chunk(static_cast<void *>(ptr), memory_chunk::units(count));
     }
+  }
+
+  /// @brief Allocates \ref n single elements into \ref out. The free single
+  /// slots are taken first, then runs of neighbouring slots carved in one go
+  /// from the largest free chunks (or new blocks), in address order
+  /// NOTE: \ref out is not sorted as a whole: the free single slots come last
+  /// freed first, and only each run is in increasing address order. Sorting
+  /// would cost more than the allocations it saves
+  void allocate_bulk(pointer *out, std::size_t n) {
+    // Elements larger than a block get a mapping each
+    if (max_count() == 0) {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = allocate(1);
+      }
+      return;
+    }
+    POOL_STAT(counters_.allocations += n)
+    POOL_STAT(counters_.bytes_in_use += n * sizeof(_Tp))
+    constexpr std::size_t unit = memory_chunk::units(1);
+
+    std::size_t filled = 0;
+    while (filled < n && (slots_ != nullptr || drain_remote_slots())) {
+      slot *head = slots_;
+      slots_ = head->ptr;
+      out[filled++] = reinterpret_cast<pointer>(head);
+    }
+
+    while (filled < n) {
+      if (bins_mask_ == 0) {
+        drain_remote_chunks();
+      }
+      const std::size_t wanted = std::max(n - filled, min_run());
+      std::size_t n_run;
+      pointer run = nullptr;
+      if (bins_mask_ != 0) {
+        // The head of the largest size class, or as much of it as is needed
+        const std::size_t bin = detail::log2_floor(bins_mask_);
+        memory_chunk *const chunk = chunks_[bin];
+        n_run = std::min(wanted, (memory_chunk::size(*chunk) +
+                                  memory_chunk::padding()) /
+                                     unit);
+        if (n_run >= min_run()) {
+          run = get_new_and_update_chunk(bin, chunk, run_units(n_run));
+        }
+      }
+      if (run == nullptr) {
+        n_run = std::min(wanted, max_run());
+        run = allocate_impl(run_units(n_run));
+      }
+
+      char *const first = reinterpret_cast<char *>(run);
+      const std::size_t taken = std::min(n_run, n - filled);
+      for (std::size_t i = 0; i < taken; ++i) {
+        out[filled++] = reinterpret_cast<pointer>(first + i * slot_stride());
+      }
+      for (std::size_t i = n_run; i > taken; --i) {
+        deallocate_slot(
+            reinterpret_cast<pointer>(first + (i - 1) * slot_stride()));
+      }
+    }
+    POOL_TRACE(trace_bulk(TraceOp::Allocate, out, n))
+  }
+
+  /// @brief Deallocates \ref n single elements. Runs of neighbouring slots in
+  /// increasing address order (as \ref allocate_bulk hands them out) go back
+  /// to the free chunks as a whole, and are merged with the free chunks around
+  /// them when recycling slots. The others become free single slots
+  void deallocate_bulk(pointer *in, std::size_t n) {
+    if (max_count() == 0) {
+      for (std::size_t i = 0; i < n; ++i) {
+        deallocate(in[i], 1);
+      }
+      return;
+    }
+    POOL_TRACE(trace_bulk(TraceOp::Deallocate, in, n))
+    if (n == 0) {
+      return;
+    }
+    if (unlikely(!owned_by_caller())) {
+      remote_deallocate_bulk(in, n);
+      return;
+    }
+    POOL_STAT(counters_.frees += n)
+    POOL_STAT(counters_.bytes_in_use -= n * sizeof(_Tp))
+
+    for (std::size_t i = 0, j; i < n; i = j) {
+      // The run of neighbouring slots starting at in[i] (never across blocks)
+      char *const first = reinterpret_cast<char *>(in[i]);
+      BlockHeader *const block = block_of(first);
+      for (j = i + 1; j < n &&
+                      reinterpret_cast<char *>(in[j]) ==
+                          first + (j - i) * slot_stride() &&
+                      block_of(in[j]) == block;
+           ++j) {
+      }
+      const std::size_t units = (j - i) * memory_chunk::units(1);
+      if (units > memory_chunk::padding()) {
+        push_chunk(first, units - memory_chunk::padding());
+        continue;
+      }
+      for (std::size_t k = i; k < j; ++k) {
+        deallocate_slot(in[k]);
+      }
+    }
+  }
+
+#ifdef POOL_TRACE_ENABLED
+  /// @brief Records every allocate and deallocate from now on to the file
+  /// \ref path (see allocationTrace.hpp), until \ref stop_trace. Returns
+  /// false if the file could not be opened
+  bool start_trace(const char *path) {
+    TraceHeader header;
+    header.element_size = sizeof(_Tp);
+    header.block_size = _Block_Size;
+    header.recycle_slots = _Recycle_Slots;
+    header.size_classes = _Size_Classes;
+    return trace_.open(path, header);
+  }
+
+  void stop_trace() { trace_.close(); }
 #endif
+
+  /// @brief Hands the pool over to the thread \ref owner
+  /// Frees from any other thread then go through the remote lists. A default
+  /// constructed std::thread::id (the initial owner) disables the ownership
+  /// check: the caller then serializes every (de)allocation itself
+  void set_owner(std::thread::id owner) { owner_ = owner; }
+
+  std::thread::id owner() const { return owner_; }
+
+  void set_trim_policy(const TrimPolicy &policy) {
+    policy_ = policy;
+    release_large(policy_.spare_large);
+    release_empty_blocks(policy_.spare_blocks);
+    deallocate_released_segments();
+  }
+
+  const TrimPolicy &trim_policy() const { return policy_; }
+
+  /// @brief Where the blocks come from
+  block_source &get_block_source() { return source_; }
+
+  /// @brief How many blocks are taken from the source at once
+  growth_policy_type &growth_policy() { return growth_; }
+
+  /// @brief Number of blocks held, released ones included
+  std::size_t blocks() const { return n_blocks_; }
+
+  /// @brief Whether \ref ptr points into a block of this pool
+  /// NOTE: A range check with a source reserving the address range of the pool
+  /// (see \ref ReservedBlockSource), else a walk through the blocks
+  bool owns(const void *ptr) const { return owns_impl(ptr, 0); }
+
+  /// @brief Gives the empty blocks back to the system until at most \ref keep
+  /// are left, the ones idle for the policy's idle time only (see
+  /// \ref TrimPolicy::idle_time), and every spare large allocation. Folds the
+  /// free single slots back first, the ones freed by other threads included
+  /// (see \ref recycle_slots). Returns the number of blocks released
+  std::size_t trim(std::size_t keep = 0) {
+    recycle_slots();
+    release_large(0);
+    const std::size_t released = release_empty_blocks(keep);
+    deallocate_released_segments();
+    return released;
+  }
+
+  /// @brief Makes room for \ref n_slots single elements in the memory held,
+  /// taking the missing blocks from the source at once (whatever the growth
+  /// policy) and bringing the released blocks back. These blocks join the free
+  /// chunks, in address order, so that the allocations up to that size never
+  /// take a new block. Returns the number of blocks taken from the source
+  /// NOTE: See \ref prefault to fault their pages in as well. Once emptied
+  /// again, reserved blocks are kept or released like any other (see
+  /// \ref TrimPolicy::spare_blocks)
+  std::size_t reserve(std::size_t n_slots) {
+    // Elements larger than a block get a mapping each: no block would serve
+    if (max_count() == 0) {
+      return 0;
+    }
+    const std::size_t needed = memory_chunk::units(1) * n_slots;
+    std::size_t free = free_slots();
+    if (free >= needed) {
+      return 0;
+    }
+
+    std::vector<BlockHeader *> blocks;
+    while (released_ != nullptr && free < needed) {
+      memory_chunk *chunk = released_;
+      unlink_released(*chunk);
+      blocks.push_back(block_of(chunk));
+      free += slots_in_block();
+    }
+    const std::size_t n_blocks =
+        (needed - std::min(free, needed) + slots_in_block() - 1) /
+        slots_in_block();
+    if (n_blocks > 0) {
+      BlockHeader *segment = allocate_segment(n_blocks);
+      for (std::size_t i = 0; i < n_blocks; ++i) {
+        blocks.push_back(block_at(segment, i));
+      }
+    }
+
+    // The lowest address at the front of the bin
+    std::sort(blocks.begin(), blocks.end());
+    for (auto block = blocks.rbegin(); block != blocks.rend(); ++block) {
+      make_chunk(first_chunk(*block), slots_in_block());
+    }
+    return n_blocks;
   }
 
-  /// Allocator for the list that tracks free memory chunks (\ref _slots)
-  DEQUE_INLINE void *allocate_pointer() const { return chunks_ptr_; };
+  /// @brief Faults in the pages of the free chunks and of the empty blocks
+  /// (not the released ones), so that using the memory held takes no page
+  /// fault. The single slots were touched when they were freed
+  void prefault() {
+    for (memory_chunk *head : chunks_) {
+      for (memory_chunk *chunk = head; chunk != nullptr;
+           chunk = memory_chunk::next(*chunk)) {
+        detail::prefault(chunk, (memory_chunk::size(*chunk) +
+                                 memory_chunk::padding()) *
+                                    memory_chunk::alignement());
+      }
+    }
+    for (memory_chunk *chunk = empty_; chunk != nullptr;
+         chunk = memory_chunk::next(*chunk)) {
+      detail::prefault(chunk, (slots_in_block() + memory_chunk::padding()) *
+                                  memory_chunk::alignement());
+    }
+  }
+
+  /// @brief Number of empty blocks kept for reuse
+  std::size_t empty_blocks() const { return n_empty_; }
+
+  /// @brief Number of free chunks (the free single slots are not counted)
+  std::size_t free_chunks() const {
+    std::size_t count = 0;
+    for (memory_chunk *head : chunks_) {
+      for (memory_chunk *chunk = head; chunk != nullptr;
+           chunk = memory_chunk::next(*chunk)) {
+        ++count;
+      }
+    }
+    return count;
+  }
 
-  /// Deallocator for the list that tracks free memory chunks (\ref _slots)
-  DEQUE_INLINE void deallocate_pointer(void *ptr) { chunks_ptr_ = ptr; };
+  /// @brief Counters and free memory of the pool
+  /// NOTE: Walks every free chunk and single slot; the frees from other threads
+  /// are counted as soon as they happen
+  PoolStats stats() const {
+    PoolStats stats;
+#ifdef POOL_STATS_ENABLED
+    stats = counters_;
+    stats.frees += remote_frees_.load(std::memory_order_relaxed);
+    stats.bytes_in_use -= remote_bytes_.load(std::memory_order_relaxed);
+    stats.bytes_reserved =
+        large_mapped_ - remote_large_bytes_.load(std::memory_order_relaxed);
+#else
+    for (const auto &spare : large_) {
+      stats.bytes_reserved += spare.second;
+    }
+#endif
+    std::size_t resident = n_blocks_;
+    for (memory_chunk *chunk = released_; chunk != nullptr;
+         chunk = memory_chunk::next(*chunk)) {
+      --resident;
+    }
+    stats.bytes_reserved += resident * _Block_Size;
+
+    constexpr std::size_t unit = memory_chunk::alignement();
+    std::size_t largest = 0;
+    for (memory_chunk *head : chunks_) {
+      for (memory_chunk *chunk = head; chunk != nullptr;
+           chunk = memory_chunk::next(*chunk)) {
+        const std::size_t size = memory_chunk::size(*chunk);
+        ++stats.free_chunks;
+        stats.bytes_free += (size + memory_chunk::padding()) * unit;
+        largest = std::max(largest, size * unit);
+      }
+    }
+    if (n_empty_ > 0) {
+      stats.bytes_free +=
+          n_empty_ * (slots_in_block() + memory_chunk::padding()) * unit;
+      largest = slots_in_block() * unit;
+    }
+    for (slot *single = slots_; single != nullptr; single = single->ptr) {
+      stats.bytes_free += memory_chunk::units(1) * unit;
+      largest = std::max(largest, sizeof(_Tp));
+    }
+
+    if (stats.bytes_free > 0) {
+      stats.fragmentation = 1. - static_cast<double>(largest) /
+                                     static_cast<double>(stats.bytes_free);
+    }
+    return stats;
+  }
 
 private:
+  /// @brief Number of free slots: in the free chunks (headers included), the
+  /// single slots and the empty blocks
+  std::size_t free_slots() const {
+    std::size_t count = n_empty_ * (slots_in_block() + memory_chunk::padding());
+    for (memory_chunk *head : chunks_) {
+      for (memory_chunk *chunk = head; chunk != nullptr;
+           chunk = memory_chunk::next(*chunk)) {
+        count += memory_chunk::size(*chunk) + memory_chunk::padding();
+      }
+    }
+    for (slot *single = slots_; single != nullptr; single = single->ptr) {
+      count += memory_chunk::units(1);
+    }
+    return count;
+  }
+
+  /// @brief Pops a slot from the single slot free list
+  DEQUE_INLINE pointer allocate_slot() {
+    if (likely(slots_ != nullptr) || drain_remote_slots()) {
+      slot *head = slots_;
+      slots_ = head->ptr;
+      return reinterpret_cast<pointer>(head);
+    }
+    return refill_slots();
+  }
+
+  /// @brief Pushes a slot onto the single slot free list
+  /// NOTE: The link lives inside the freed slot itself, so single slots carry
+  /// no chunk header and are only merged back by \ref recycle_slots
+  DEQUE_INLINE void deallocate_slot(pointer ptr) {
+    slot *head = reinterpret_cast<slot *>(ptr);
+    head->ptr = slots_;
+    slots_ = head;
+  }
+
+  /// @brief Frees the \ref count slots at \ref first as single slots. The
+  /// slots too few for one more element become a scrap
+  void scatter_slots(char *first, std::size_t count) {
+    const std::size_t n_singles = count / memory_chunk::units(1);
+    for (std::size_t i = n_singles; i > 0; --i) {
+      deallocate_slot(
+          reinterpret_cast<pointer>(first + (i - 1) * slot_stride()));
+    }
+    char *const scrap = first + n_singles * slot_stride();
+    if (count % memory_chunk::units(1) != 0 &&
+        tail_slots(slot_index(block_of(scrap), scrap)) == 0) {
+      keep_scrap(scrap, count % memory_chunk::units(1));
+    }
+  }
+
+  /// @brief Keeps the \ref count slots at \ref ptr, too few for an element,
+  /// until \ref recycle_slots folds them back with their neighbours
+  /// NOTE: A scrap is linked through its first word, whose lowest bit is set
+  /// if it spans a single slot; otherwise its second word holds its size
+  void keep_scrap(char *ptr, std::size_t count) {
+    std::uintptr_t *const words = reinterpret_cast<std::uintptr_t *>(ptr);
+    words[0] = reinterpret_cast<std::uintptr_t>(scraps_) | (count == 1);
+    if (count > 1) {
+      words[1] = count;
+    }
+    scraps_ = ptr;
+  }
+
+  static char *next_scrap(const char *scrap) {
+    return reinterpret_cast<char *>(
+        *reinterpret_cast<const std::uintptr_t *>(scrap) &
+        ~std::uintptr_t(1));
+  }
+
+  static std::size_t scrap_size(const char *scrap) {
+    const std::uintptr_t *const words =
+        reinterpret_cast<const std::uintptr_t *>(scrap);
+    return (words[0] & 1) ? 1 : words[1];
+  }
+
+  /// @brief Carves a run of single slots from the free chunks (or a new block)
+  /// and threads them in address order onto the single slot free list
+  pointer refill_slots() {
+    std::size_t n_run = slot_batch();
+    pointer run = allocate_from_bins(run_units(n_run));
+    if (!run) {
+      n_run = min_run();
+      run = allocate_from_bins(run_units(n_run));
+    }
+    if (!run) {
+      n_run = slot_batch();
+      run = allocate_impl(run_units(n_run));
+    }
+
+    char *const first = reinterpret_cast<char *>(run);
+    for (std::size_t i = n_run - 1; i > 0; --i) {
+      deallocate_slot(reinterpret_cast<pointer>(first + i * slot_stride()));
+    }
+    return run;
+  }
+
+  /// @brief Slots to ask the chunk lists for a run of \ref n single slots
+  /// NOTE: A run handed out by the chunk lists comes with padding() extra
+  /// slots: asking for n * units(1) - padding() leaves none over (unlike
+  /// n * units(1), whenever padding() is not a multiple of units(1))
+  static constexpr std::size_t run_units(std::size_t n) {
+    return n * memory_chunk::units(1) - memory_chunk::padding();
+  }
+
+  /// @brief Shortest run of single slots that the chunk lists can hand out
+  static constexpr std::size_t min_run() {
+    return memory_chunk::padding() / memory_chunk::units(1) + 1;
+  }
+
+  /// @brief Longest run of single slots, a whole block
+  static constexpr std::size_t max_run() {
+    return (slots_in_block() + memory_chunk::padding()) /
+           memory_chunk::units(1);
+  }
+
+  /// @brief Number of single slots carved at once by \ref refill_slots
+  static constexpr std::size_t slot_batch() {
+    return std::min<std::size_t>(std::max(max_run(), min_run()), 64);
+  }
+
+  /// @brief Bytes between two consecutive single slots
+  static constexpr std::size_t slot_stride() {
+    return memory_chunk::units(1) * memory_chunk::alignement();
+  }
+
   /// @brief Pool allocator implementation
   inline pointer allocate_impl(std::size_t count, void * = nullptr) {
 
-    // Tries to get a chunk from the free memory chunks list
-    auto chunk = chunks_.begin();
-    const auto end = chunks_.end();
-    while (chunk != end) {
-      if (memory_chunk::size(*chunk) >= count) {
-        return get_new_and_update_chunk(chunk, count);
-      }
-      ++chunk;
+    // Tries to get a chunk from the free memory chunks lists
+    if (auto ptr = allocate_from_bins(count)) {
+      return ptr;
     }
 
-    // If there are no available chunks (either because they are too small or
-    // inexistent) one might recycle the chunks
-    if (_Recycle_Slots) {
-      // We may only recycle if count > 1 (elseways implies that there are no
-      // available chunks)
-      if (count > 1) {
-        recycle_slots();
-
-        // Try allocating from recycled chunks
-        chunk = chunks_.begin();
-        if (memory_chunk::size(*chunk) >= count) {
-          return get_new_and_update_chunk(chunk, count);
-        }
+    // Chunks freed by other threads may fit
+    if (drain_remote_chunks()) {
+      if (auto ptr = allocate_from_bins(count)) {
+        return ptr;
       }
     }
 
     // If none of the above worked, allocate a new block
     allocate_block();
-    chunk = chunks_.begin();
-    return get_new_and_update_chunk(chunk, count);
+    const std::size_t bin = bin_index(slots_in_block());
+    return get_new_and_update_chunk(bin, chunks_[bin], count);
   }
 
-  /// @brief Takes a chunk from the chunks' free list and either create a new
-  /// chunk from it or recycle it
-  template <typename Iterator>
-  inline pointer get_new_and_update_chunk(Iterator &chunk, std::size_t count) {
+  /// @brief Finds a chunk with at least \ref count slots in the size class
+  /// bins. Returns nullptr if there is none
+  inline pointer allocate_from_bins(std::size_t count) {
+    POOL_STAT(++counters_.searches)
+    const std::size_t bin = bin_index(count);
+    memory_chunk *const head = chunks_[bin];
 
-    static_assert(
-        std::is_same<decltype(((decltype(chunks_) *)nullptr)->begin()),
-                     Iterator>::value,
-        "Not a chunk list iterator");
+    // The head of the request's own size class is the cheapest candidate
+    if (head != nullptr && memory_chunk::size(*head) >= count) {
+      return get_new_and_update_chunk(bin, head, count);
+    }
+
+    // Any chunk from a larger size class fits: pick the smallest such class
+    const std::size_t larger =
+        bins_mask_ & all_bins() & ~((std::size_t(2) << bin) - 1);
+    if (larger) {
+      const std::size_t other = detail::count_trailing_zeros(larger);
+      return get_new_and_update_chunk(other, chunks_[other], count);
+    }
+
+    // Last resort: first-fit scan of the request's own size class
+    POOL_STAT(std::size_t scanned = 0)
+    for (memory_chunk *chunk = head; chunk != nullptr;
+         chunk = memory_chunk::next(*chunk)) {
+      POOL_EVENT(scan, 1)
+      POOL_STAT(++scanned)
+      if (memory_chunk::size(*chunk) >= count) {
+        POOL_STAT(count_scan(scanned))
+        return get_new_and_update_chunk(bin, chunk, count);
+      }
+    }
+    POOL_STAT(count_scan(scanned))
+    return nullptr;
+  }
 
-    // If there's not enough memory to create a new chunk (which will be a node
-    // of the free list)
-    // TODO: find alternative without erasing
+#ifdef POOL_TRACE_ENABLED
+  void trace_bulk(TraceOp op, pointer *ptrs, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      trace_.record(op, ptrs[i], 1);
+    }
+  }
+#endif
+
+#ifdef POOL_STATS_ENABLED
+  void count_scan(std::size_t scanned) {
+    counters_.scanned += scanned;
+    counters_.max_scan = std::max(counters_.max_scan, scanned);
+  }
+#endif
+
+  /// @brief Takes \ref count slots (plus the padding) from a free chunk, either
+  /// from its end or, if the rest could not hold a chunk, the whole chunk
+  inline pointer get_new_and_update_chunk(std::size_t bin,
+                                          memory_chunk *chunk,
+                                          std::size_t count) {
+    untag(*chunk);
+
+    // If there's not enough memory left for a new chunk (which will be a node
+    // of the free list), the slots past the allocation become single slots
     if (!memory_chunk::can_alloc_node(*chunk, count)) {
-      chunks_.erase(chunk);
-      return static_cast<pointer>(chunks_ptr_);
+      unlink(bin, *chunk);
+      scatter_slots(
+          static_cast<char *>(memory_chunk::address_at(*chunk, count)),
+          memory_chunk::size(*chunk) - count);
+      return reinterpret_cast<pointer>(chunk);
     }
 
     auto ptr = memory_chunk::get_new_chunk_ptr(*chunk, count);
+    tag(*chunk);
+
+    // The chunk shrank and may now belong to a smaller size class
+    const std::size_t new_bin = bin_index(memory_chunk::size(*chunk));
+    if (new_bin != bin) {
+      unlink(bin, *chunk);
+      link(new_bin, *chunk);
+    }
     return static_cast<pointer>(ptr);
   }
 
-  /// @brief Allocates a memory block
+  /// @brief Allocates a memory block, reusing an empty one if possible
   DEQUE_INLINE void allocate_block() {
-    auto block = operator new(_Block_Size);
-    blocks_.push_front(block); // bookkeping of allocated blocks
+    // The most recently emptied block is the most likely to be still cached
+    if (empty_ != nullptr) {
+      memory_chunk *chunk = empty_;
+      unlink_empty(*chunk);
+      make_chunk(chunk, slots_in_block());
+      return;
+    }
+    if (released_ != nullptr) {
+      POOL_EVENT(new_block, 1)
+      POOL_STAT(++counters_.blocks_allocated)
+      memory_chunk *chunk = released_;
+      unlink_released(*chunk);
+      make_chunk(chunk, slots_in_block());
+      return;
+    }
+
+    const std::size_t n_blocks =
+        std::max<std::size_t>(growth_.blocks(n_blocks_), 1);
+    BlockHeader *segment = allocate_segment(n_blocks);
+
+    // The other blocks are empty, the first one goes to the bins
+    for (std::size_t i = n_blocks - 1; i > 0; --i) {
+      keep_empty(first_chunk(block_at(segment, i)));
+    }
+    make_chunk(first_chunk(segment), slots_in_block());
+  }
+
+  /// @brief Takes a segment of \ref n_blocks blocks from the source and writes
+  /// the headers of its blocks (which are left out of the free structures)
+  BlockHeader *allocate_segment(std::size_t n_blocks) {
+    POOL_EVENT(new_block, 1)
+    POOL_STAT(counters_.blocks_allocated += n_blocks)
+    void *const first = source_.allocate(n_blocks * _Block_Size, _Block_Size);
+    blocks_.push_front(first); // bookkeping of allocated segments
+    n_blocks_ += n_blocks;
+
+    BlockHeader *segment = new (first) BlockHeader();
+    segment->segment_ = segment;
+    segment->self_ = blocks_.begin();
+    segment->n_blocks_ = n_blocks;
+    segment->n_released_ = 0;
+    for (std::size_t i = 1; i < n_blocks; ++i) {
+      new (block_at(segment, i)) BlockHeader();
+      block_at(segment, i)->segment_ = segment;
+    }
+    return segment;
+  }
+
+  /// @brief The block \ref index of \ref segment
+  DEQUE_INLINE static BlockHeader *block_at(BlockHeader *segment,
+                                            std::size_t index) {
+    return reinterpret_cast<BlockHeader *>(reinterpret_cast<char *>(segment) +
+                                           index * _Block_Size);
+  }
+
+  /// @brief Ownership check of a source that can tell
+  template <class _Source = block_source>
+  auto owns_impl(const void *ptr, int) const
+      -> decltype(std::declval<const _Source &>().contains(ptr)) {
+    return source_.contains(ptr);
+  }
+
+  bool owns_impl(const void *ptr, long) const {
+    const char *byte = static_cast<const char *>(ptr);
+    return std::any_of(blocks_.begin(), blocks_.end(), [byte](void *block) {
+      const char *first = static_cast<const char *>(block);
+      return byte >= first &&
+             byte < first + static_cast<BlockHeader *>(block)->n_blocks_ *
+                                _Block_Size;
+    });
+  }
 
-    chunks_ptr_ = block;
-    chunks_.emplace_front(chunks_ptr_, slots_in_block());
+  /// @brief Where the chunk spanning a whole block starts
+  DEQUE_INLINE static void *first_chunk(BlockHeader *block) {
+    return slot_at(block, header_slots());
+  }
+
+  /// @brief Keeps a block whose slots are all free (at \ref ptr) for reuse,
+  /// then applies the trim policy
+  void retire_block(void *ptr) {
+    keep_empty(ptr);
+    if (unlikely(n_empty_ > policy_.spare_blocks)) {
+      release_empty_blocks(policy_.spare_blocks);
+    }
+  }
+
+  /// @brief Adds the block whose slots are all free (at \ref ptr) to the
+  /// empty blocks, as the newest one
+  void keep_empty(void *ptr) {
+    memory_chunk *chunk = new (ptr) memory_chunk(slots_in_block());
+    if (policy_.idle_time != std::chrono::steady_clock::duration::zero()) {
+      new (memory_chunk::address_at(*chunk, 0))
+          std::chrono::steady_clock::time_point(
+              std::chrono::steady_clock::now());
+    }
+
+    // The newest empty block at the front, the oldest at the back
+    memory_chunk::prev(*chunk) = nullptr;
+    memory_chunk::next(*chunk) = empty_;
+    if (empty_ != nullptr) {
+      memory_chunk::prev(*empty_) = chunk;
+    } else {
+      oldest_empty_ = chunk;
+    }
+    empty_ = chunk;
+    ++n_empty_;
+  }
+
+  /// @brief Removes \ref chunk from the empty blocks
+  void unlink_empty(memory_chunk &chunk) {
+    memory_chunk *const prev = memory_chunk::prev(chunk);
+    memory_chunk *const next = memory_chunk::next(chunk);
+    (prev != nullptr ? memory_chunk::next(*prev) : empty_) = next;
+    (next != nullptr ? memory_chunk::prev(*next) : oldest_empty_) = prev;
+    --n_empty_;
+  }
+
+  /// @brief Releases the oldest empty blocks until at most \ref keep are left,
+  /// only the ones idle for longer than the policy's idle time. Returns the
+  /// number of blocks released
+  std::size_t release_empty_blocks(std::size_t keep) {
+    const bool timed =
+        policy_.idle_time != std::chrono::steady_clock::duration::zero();
+    const auto now = timed ? std::chrono::steady_clock::now()
+                           : std::chrono::steady_clock::time_point();
+
+    std::size_t released = 0;
+    while (n_empty_ > keep) {
+      memory_chunk *chunk = oldest_empty_;
+      if (timed &&
+          now - *static_cast<std::chrono::steady_clock::time_point *>(
+                    memory_chunk::address_at(*chunk, 0)) <
+              policy_.idle_time) {
+        break;
+      }
+      unlink_empty(*chunk);
+      release_block(*chunk);
+      ++released;
+    }
+    return released;
+  }
+
+  /// @brief Gives the block of the empty \ref chunk back to the system
+  /// NOTE: A segment is deallocated as a whole: until all of its blocks were
+  /// released, a released block only has its pages dropped (where possible)
+  void release_block(memory_chunk &chunk) {
+    POOL_EVENT(release_block, 1)
+    POOL_STAT(++counters_.blocks_freed)
+    BlockHeader *const segment = block_of(&chunk)->segment_;
+    const bool single = segment->n_blocks_ == 1;
+    if ((single && policy_.release == BlockRelease::Delete) ||
+        (!drop_pages(chunk) && single)) {
+      deallocate_segment(segment);
+      return;
+    }
+
+    keep_released(chunk);
+    if (segment->n_released_ == segment->n_blocks_ &&
+        policy_.release == BlockRelease::Delete) {
+      deallocate_segment(segment);
+    }
+  }
+
+  /// @brief Adds the block of the empty \ref chunk to the released blocks
+  void keep_released(memory_chunk &chunk) {
+    memory_chunk::prev(chunk) = nullptr;
+    memory_chunk::next(chunk) = released_;
+    if (released_ != nullptr) {
+      memory_chunk::prev(*released_) = &chunk;
+    }
+    released_ = &chunk;
+    ++block_of(&chunk)->segment_->n_released_;
+  }
+
+  /// @brief Removes \ref chunk from the released blocks
+  void unlink_released(memory_chunk &chunk) {
+    memory_chunk *const prev = memory_chunk::prev(chunk);
+    memory_chunk *const next = memory_chunk::next(chunk);
+    (prev != nullptr ? memory_chunk::next(*prev) : released_) = next;
+    if (next != nullptr) {
+      memory_chunk::prev(*next) = prev;
+    }
+    --block_of(&chunk)->segment_->n_released_;
+  }
+
+  /// @brief Deallocates the segments whose blocks were all released while the
+  /// policy kept them mapped (see \ref BlockRelease), once it no longer does
+  void deallocate_released_segments() {
+    if (released_ == nullptr || policy_.release != BlockRelease::Delete) {
+      return;
+    }
+    for (auto it = blocks_.begin(); it != blocks_.end();) {
+      BlockHeader *const segment = static_cast<BlockHeader *>(*it++);
+      if (segment->n_released_ == segment->n_blocks_) {
+        deallocate_segment(segment);
+      }
+    }
+  }
+
+  /// @brief Drops the pages of the block of the empty \ref chunk, all but the
+  /// ones holding the headers. Returns false if there were none to drop
+  bool drop_pages(memory_chunk &chunk) {
+#if defined(__unix__) || defined(__APPLE__)
+    static const std::uintptr_t page =
+        static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t first =
+        (reinterpret_cast<std::uintptr_t>(memory_chunk::address_at(chunk, 0)) +
+         page - 1) &
+        ~(page - 1);
+    const std::uintptr_t last =
+        reinterpret_cast<std::uintptr_t>(block_of(&chunk)) + _Block_Size;
+    if (first < last) {
+#ifdef MADV_FREE
+      const int advice =
+          policy_.release == BlockRelease::Free ? MADV_FREE : MADV_DONTNEED;
+#else
+      const int advice = MADV_DONTNEED;
+#endif
+      madvise(reinterpret_cast<void *>(first), last - first, advice);
+      return true;
+    }
+#endif
+    return false;
+  }
+
+  /// @brief Gives a whole segment back to the block source
+  /// NOTE: Either none or all of its blocks were released
+  void deallocate_segment(BlockHeader *segment) {
+    const std::size_t n_blocks = segment->n_blocks_;
+    if (segment->n_released_ > 0) {
+      for (std::size_t i = 0; i < n_blocks; ++i) {
+        unlink_released(
+            *static_cast<memory_chunk *>(first_chunk(block_at(segment, i))));
+      }
+    }
+
+    n_blocks_ -= n_blocks;
+    blocks_.erase(segment->self_);
+    for (std::size_t i = n_blocks; i-- > 0;) {
+      block_at(segment, i)->~BlockHeader();
+    }
+    source_.deallocate(static_cast<void *>(segment), n_blocks * _Block_Size,
+                       _Block_Size);
+  }
+
+  /// @brief Bytes actually allocated for \ref count elements past
+  /// \ref max_count: whole pages, in size classes 1/4 of a power of two apart
+  static std::size_t large_size(std::size_t count) {
+    const std::size_t bytes = count * sizeof(_Tp);
+    const std::size_t quarter =
+        (std::size_t(1) << detail::log2_floor(bytes)) / 4;
+    const std::size_t step =
+        quarter > detail::page_size() ? quarter : detail::page_size();
+    return (bytes + step - 1) / step * step;
+  }
+
+  /// @brief Takes a spare large allocation of the same size class, or maps
+  /// a new one (the elements are not constructed)
+  pointer allocate_large(std::size_t count) {
+    const std::size_t bytes = large_size(count);
+    for (auto spare = large_.rbegin(); spare != large_.rend(); ++spare) {
+      if (spare->second == bytes) {
+        void *ptr = spare->first;
+        large_.erase(std::next(spare).base());
+        return static_cast<pointer>(ptr);
+      }
+    }
+    POOL_EVENT(large_map, 1)
+    POOL_STAT(large_mapped_ += bytes)
+    return static_cast<pointer>(
+        large_source_.allocate(bytes, large_alignment()));
+  }
+
+  /// @brief Alignment of the large allocations: a page, or a slot if larger
+  static std::size_t large_alignment() {
+    return std::max(detail::page_size(), memory_chunk::alignement());
+  }
+
+  /// @brief Keeps a large allocation for reuse, giving back the oldest spare
+  /// one past \ref TrimPolicy::spare_large
+  void deallocate_large(pointer ptr, std::size_t count) {
+    large_.emplace_back(static_cast<void *>(ptr), large_size(count));
+    release_large(policy_.spare_large);
+  }
+
+  /// @brief Gives back the oldest spare large allocations until at most
+  /// \ref keep are left
+  void release_large(std::size_t keep) {
+    if (large_.size() <= keep) {
+      return;
+    }
+    const auto last = large_.end() - static_cast<std::ptrdiff_t>(keep);
+    POOL_EVENT(large_unmap, last - large_.begin())
+    for (auto spare = large_.begin(); spare != last; ++spare) {
+      POOL_STAT(large_mapped_ -= spare->second)
+      large_source_.deallocate(spare->first, spare->second,
+                               large_alignment());
+    }
+    large_.erase(large_.begin(), last);
+  }
+
+  /// @brief Whether the calling thread may touch the free lists
+  DEQUE_INLINE bool owned_by_caller() const {
+    return owner_ == std::thread::id() || owner_ == std::this_thread::get_id();
+  }
+
+  /// @brief Frees memory on behalf of a thread that does not own the pool
+  /// A freed single slot is linked through its first Slot; a freed chunk (of at
+  /// least padding() + 1 slots) also stores its size in the second Slot
+  void remote_deallocate(pointer ptr, std::size_t count) {
+    POOL_STAT(remote_frees_.fetch_add(1, std::memory_order_relaxed))
+    POOL_STAT(remote_bytes_.fetch_add(count * sizeof(_Tp),
+                                      std::memory_order_relaxed))
+    // NOTE: Large allocations skip the spares, the source is thread-safe
+    if (unlikely(count > max_count())) {
+      POOL_STAT(remote_large_bytes_.fetch_add(large_size(count),
+                                              std::memory_order_relaxed))
+      large_source_.deallocate(static_cast<void *>(ptr), large_size(count),
+                               large_alignment());
+      return;
+    }
+    slot *node = reinterpret_cast<slot *>(ptr);
+    if (count == 1) {
+      push_remote(remote_slots_, node);
+      return;
+    }
+    node[1].size = memory_chunk::units(count);
+    push_remote(remote_chunks_, node);
+  }
+
+  /// @brief Frees single elements on behalf of a thread that does not own
+  /// the pool, pushing all of them at once
+  void remote_deallocate_bulk(pointer *in, std::size_t n) {
+    POOL_STAT(remote_frees_.fetch_add(n, std::memory_order_relaxed))
+    POOL_STAT(remote_bytes_.fetch_add(n * sizeof(_Tp),
+                                      std::memory_order_relaxed))
+    slot *const last = reinterpret_cast<slot *>(in[0]);
+    slot *first = last;
+    for (std::size_t i = 1; i < n; ++i) {
+      slot *node = reinterpret_cast<slot *>(in[i]);
+      node->ptr = first;
+      first = node;
+    }
+    push_remote(remote_slots_, first, last);
+  }
+
+  /// @brief Lock-free push onto a multiple producer, single consumer list
+  static void push_remote(std::atomic<slot *> &head, slot *node) {
+    push_remote(head, node, node);
+  }
+
+  /// @brief Same, for the nodes from \ref first to \ref last (already linked)
+  static void push_remote(std::atomic<slot *> &head, slot *first,
+                          slot *last) {
+    last->ptr = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(last->ptr, first,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  /// @brief Moves the single slots freed by other threads onto the single slot
+  /// free list (which must be empty). Returns whether there were any
+  DEQUE_INLINE bool drain_remote_slots() {
+    if (likely(remote_slots_.load(std::memory_order_relaxed) == nullptr)) {
+      return false;
+    }
+    // Both lists are linked through Slot::ptr: take the whole list at once
+    slots_ = remote_slots_.exchange(nullptr, std::memory_order_acquire);
+    return true;
+  }
+
+  /// @brief Moves the chunks freed by other threads to the size class bins.
+  /// Returns whether there were any
+  bool drain_remote_chunks() {
+    if (remote_chunks_.load(std::memory_order_relaxed) == nullptr) {
+      return false;
+    }
+    POOL_EVENT(remote_drain, 1)
+    slot *node = remote_chunks_.exchange(nullptr, std::memory_order_acquire);
+    while (node != nullptr) {
+      slot *next = node->ptr;
+      push_chunk(static_cast<void *>(node), node[1].size);
+      node = next;
+    }
+    return true;
+  }
+
+  /// @brief Frees \ref count slots (plus the padding) at \ref ptr, merging them
+  /// with the free chunks right before and right after when recycling slots
+  DEQUE_INLINE void push_chunk(void *ptr, std::size_t count) {
+    BlockHeader *const block = block_of(ptr);
+    if (_Recycle_Slots) {
+      const std::size_t first = slot_index(block, ptr);
+      const std::size_t last = first + memory_chunk::padding() + count;
+
+      // The slot before is the footer of a free chunk
+      // NOTE: first > 0 since the block starts with its header
+      if (block->tags().test(first - 1)) {
+        memory_chunk *left =
+            memory_chunk::from_footer(slot_at(block, first - 1));
+        unlink(bin_index(memory_chunk::size(*left)), *left);
+        untag(*left);
+        count += memory_chunk::size(*left) + memory_chunk::padding();
+        ptr = left;
+      }
+
+      // The slot after is the header of a free chunk
+      if (last < _Block_Size / memory_chunk::alignement() &&
+          block->tags().test(last)) {
+        memory_chunk *right =
+            reinterpret_cast<memory_chunk *>(slot_at(block, last));
+        unlink(bin_index(memory_chunk::size(*right)), *right);
+        untag(*right);
+        count += memory_chunk::size(*right) + memory_chunk::padding();
+      }
+    }
+    count +=
+        tail_slots(slot_index(block, ptr) + memory_chunk::padding() + count);
+    if (unlikely(count == slots_in_block())) {
+      retire_block(ptr);
+      return;
+    }
+    make_chunk(ptr, count);
+  }
+
+  /// @brief Creates a free chunk of \ref count slots at \ref ptr
+  DEQUE_INLINE void make_chunk(void *ptr, std::size_t count) {
+    memory_chunk *chunk = new (ptr) memory_chunk(count);
+    link(bin_index(count), *chunk);
+    tag(*chunk);
+  }
+
+  /// @brief Pushes \ref chunk at the front of the size class \ref bin
+  DEQUE_INLINE void link(std::size_t bin, memory_chunk &chunk) {
+    memory_chunk *const head = chunks_[bin];
+    memory_chunk::prev(chunk) = nullptr;
+    memory_chunk::next(chunk) = head;
+    if (head != nullptr) {
+      memory_chunk::prev(*head) = &chunk;
+    }
+    chunks_[bin] = &chunk;
+    bins_mask_ |= std::size_t(1) << bin;
+  }
+
+  /// @brief Removes \ref chunk from the size class \ref bin
+  DEQUE_INLINE void unlink(std::size_t bin, memory_chunk &chunk) {
+    memory_chunk *const prev = memory_chunk::prev(chunk);
+    memory_chunk *const next = memory_chunk::next(chunk);
+    if (prev != nullptr) {
+      memory_chunk::next(*prev) = next;
+    } else {
+      chunks_[bin] = next;
+    }
+    if (next != nullptr) {
+      memory_chunk::prev(*next) = prev;
+    }
+    if (chunks_[bin] == nullptr) {
+      bins_mask_ &= ~(std::size_t(1) << bin);
+    }
+  }
+
+  /// @brief Sets the boundary tags and the footer of a free chunk
+  DEQUE_INLINE void tag(memory_chunk &chunk) {
+    if (_Recycle_Slots) {
+      BlockHeader *const block = block_of(&chunk);
+      const std::size_t first = slot_index(block, &chunk);
+      block->tags().set(first);
+      block->tags().set(first + memory_chunk::padding() +
+                       memory_chunk::size(chunk) - 1);
+      *memory_chunk::footer_ptr(chunk) = memory_chunk::size(chunk);
+    }
+  }
+
+  /// @brief Clears the boundary tags of a chunk leaving the free lists
+  DEQUE_INLINE void untag(memory_chunk &chunk) {
+    if (_Recycle_Slots) {
+      BlockHeader *const block = block_of(&chunk);
+      const std::size_t first = slot_index(block, &chunk);
+      block->tags().reset(first);
+      block->tags().reset(first + memory_chunk::padding() +
+                         memory_chunk::size(chunk) - 1);
+    }
+  }
+
+  /// @brief The block holding \ref ptr (blocks are aligned to their size)
+  DEQUE_INLINE static BlockHeader *block_of(const void *ptr) {
+    return reinterpret_cast<BlockHeader *>(
+        reinterpret_cast<std::uintptr_t>(ptr) & ~(_Block_Size - 1));
+  }
+
+  /// @brief Index of the slot at \ref ptr in \ref block
+  DEQUE_INLINE static std::size_t slot_index(const BlockHeader *block,
+                                             const void *ptr) {
+    return static_cast<std::size_t>(static_cast<const char *>(ptr) -
+                                    reinterpret_cast<const char *>(block)) /
+           memory_chunk::alignement();
+  }
+
+  /// @brief Number of slots from the slot \ref index to the end of its block,
+  /// if too few for an element, or zero
+  /// NOTE: Such slots are never handed out nor kept in the free lists: they
+  /// belong to whatever ends right before them
+  DEQUE_INLINE static std::size_t tail_slots(std::size_t index) {
+    const std::size_t tail = _Block_Size / memory_chunk::alignement() - index;
+    return tail < memory_chunk::units(1) ? tail : 0;
+  }
+
+  /// @brief Address of the slot \ref index of \ref block
+  DEQUE_INLINE static void *slot_at(BlockHeader *block, std::size_t index) {
+    return reinterpret_cast<char *>(block) + index * memory_chunk::alignement();
+  }
+
+  /// @brief The bits of the non-empty bins mask that are size classes
+  /// NOTE: Lets the compiler see that no bin past the last one is looked up
+  static constexpr std::size_t all_bins() {
+    return ~std::size_t(0) >>
+           (std::numeric_limits<std::size_t>::digits - _Size_Classes);
+  }
+
+  /// @brief Size class of a chunk with \ref count slots
+  static constexpr std::size_t bin_index(std::size_t count) {
+    return detail::log2_floor(count) < _Size_Classes - 1
+               ? detail::log2_floor(count)
+               : _Size_Classes - 1;
   }
 
 public:
-  /// @brief Recycles the free chunks list by merging deallocated chunks (if
-  /// physically close in memory)
+  /// @brief Folds the free single slots back into chunks and merges the free
+  /// chunks that are physically next to each other, the ones freed by other
+  /// threads included
+  /// NOTE: Sorts every free piece by address, so it is never called implicitly
   void recycle_slots() {
+    POOL_EVENT(recycle, 1)
+    POOL_STAT(++counters_.recycles)
+    drain_remote_chunks();
+
+    // gather the chunks of all the size classes and the single slots
+    std::vector<std::pair<char *, std::size_t>> pieces;
+    for (memory_chunk *&head : chunks_) {
+      for (memory_chunk *chunk = head; chunk != nullptr;
+           chunk = memory_chunk::next(*chunk)) {
+        untag(*chunk);
+        pieces.emplace_back(reinterpret_cast<char *>(chunk),
+                            memory_chunk::size(*chunk) +
+                                memory_chunk::padding());
+      }
+      head = nullptr;
+    }
+    bins_mask_ = 0;
+    do {
+      for (slot *single = slots_; single != nullptr; single = single->ptr) {
+        pieces.emplace_back(reinterpret_cast<char *>(single),
+                            memory_chunk::units(1));
+      }
+      slots_ = nullptr;
+    } while (drain_remote_slots());
+    for (char *scrap = scraps_; scrap != nullptr; scrap = next_scrap(scrap)) {
+      pieces.emplace_back(scrap, scrap_size(scrap));
+    }
+    scraps_ = nullptr;
+
     // sort memory slots
-    chunks_.sort([](memory_chunk &a, memory_chunk &b) {
-      return memory_chunk::address(a) < memory_chunk::address(b);
-    });
+    std::sort(pieces.begin(), pieces.end());
 
-    // try merging them
-    auto current = chunks_.begin();
-    auto next = current;
-    ++next;
-    while (current != chunks_.end()) {
-      if (memory_chunk::merge_chunks(*current, *next)) {
-        next = chunks_.erase(next);
-      } else {
-        ++current;
-        ++next;
-      }
-    }
-    // sort in descending order
-    chunks_.sort([](memory_chunk &a, memory_chunk &b) {
-      return memory_chunk::size(a) > memory_chunk::size(b);
-    });
+    // try merging them (never across blocks)
+    std::size_t merged = 0;
+    for (const auto &piece : pieces) {
+      if (merged > 0) {
+        auto &last = pieces[merged - 1];
+        if (last.first + last.second * memory_chunk::alignement() ==
+                piece.first &&
+            block_of(last.first) == block_of(piece.first)) {
+          last.second += piece.second;
+          continue;
+        }
+      }
+      pieces[merged++] = piece;
+    }
+
+    // and scatter them back, the lowest addresses at the front of the lists
+    while (merged-- > 0) {
+      auto &piece = pieces[merged];
+      BlockHeader *const block = block_of(piece.first);
+      if (tail_slots(slot_index(block, piece.first)) != 0) {
+        continue;
+      }
+      piece.second += tail_slots(slot_index(block, piece.first) + piece.second);
+      if (piece.second == slots_in_block() + memory_chunk::padding()) {
+        retire_block(piece.first);
+        continue;
+      }
+      if (piece.second > memory_chunk::padding()) {
+        make_chunk(piece.first, piece.second - memory_chunk::padding());
+        continue;
+      }
+      scatter_slots(piece.first, piece.second);
+    }
   }
 
 public:
-  /// A list of the allocated blocks (of \ref _Block_Size)
+  /// A list of the allocated segments (of one or more blocks of
+  /// \ref _Block_Size)
   std::list<void *> blocks_;
 
-  /// A list of the free memory chunks
-  std::list<memory_chunk, list_allocator> chunks_;
+  /// Number of blocks in the segments
+  std::size_t n_blocks_ = 0;
+
+  growth_policy_type growth_;
+
+  /// The free memory chunks, one intrusive list per size class
+  memory_chunk *chunks_[_Size_Classes] = {};
+
+  /// Bit i is set if the size class i has free chunks
+  std::size_t bins_mask_ = 0;
+
+  /// The empty blocks, newest first (linked through their chunk headers)
+  memory_chunk *empty_ = nullptr;
+  memory_chunk *oldest_empty_ = nullptr;
+  std::size_t n_empty_ = 0;
+
+  /// The empty blocks whose pages were given back (see \ref BlockRelease),
+  /// linked both ways through their chunk headers
+  memory_chunk *released_ = nullptr;
+
+  TrimPolicy policy_;
+
+  block_source source_;
 
-  /// A crucial pointer needed for the free memory chunks (de)allocation
-  void *chunks_ptr_;
+  /// Spare large allocations (and their size), the most recently freed last
+  std::vector<std::pair<void *, std::size_t>> large_;
+  LargeBlockSource large_source_;
+
+  /// Intrusive LIFO list of free single slots (linked through Slot::ptr)
+  slot *slots_ = nullptr;
+
+  /// Slots too few for an element, left over by a carve (see \ref keep_scrap)
+  char *scraps_ = nullptr;
+
+  /// The thread allowed to allocate and to free without synchronization (none
+  /// by default, see \ref set_owner)
+  std::thread::id owner_;
+
+  /// Single slots and chunks freed by other threads, drained by the owner
+  std::atomic<slot *> remote_slots_{nullptr};
+  std::atomic<slot *> remote_chunks_{nullptr};
+
+#ifdef POOL_TRACE_ENABLED
+  /// See \ref start_trace
+  detail::TraceWriter trace_;
+#endif
+
+#ifdef POOL_STATS_ENABLED
+  /// See \ref stats
+  PoolStats counters_;
+
+  /// Bytes of the large allocations mapped (in use or spare)
+  std::size_t large_mapped_ = 0;
+
+  /// Counters of the frees from other threads
+  std::atomic<std::size_t> remote_frees_{0};
+  std::atomic<std::size_t> remote_bytes_{0};
+  std::atomic<std::size_t> remote_large_bytes_{0};
+#endif
 
 private:
-  static_assert(_Block_Size >=
-                    2 * memory_chunk::padding() * memory_chunk::alignement(),
+  static_assert(_Block_Size / memory_chunk::alignement() >
+                    header_slots() + 3 * memory_chunk::padding(),
+                "_Block_Size too small for the alignment of the slots");
+  static_assert(slots_in_block() > 2 * memory_chunk::padding(),
                 "_Block_Size trivially small");
   static_assert(!(_Block_Size & (_Block_Size - 1)),
                 "_Block_Size not a power of 2");
-  static_assert((std::is_same<decltype(chunks_),
-                              std::list<memory_chunk, list_allocator>>::value &&
-                 memory_chunk::pointers_in_chunk() == 2) ||
-                    (std::is_same<decltype(chunks_),
-                                  std::forward_list<memory_chunk,
-                                                    list_allocator>>::value &&
-                     memory_chunk::pointers_in_chunk() == 1),
+  static_assert(_Size_Classes >= 1 &&
+                    _Size_Classes <= std::numeric_limits<std::size_t>::digits,
+                "_Size_Classes must fit in the non-empty bins mask");
+  static_assert(sizeof(memory_chunk) <=
+                    memory_chunk::padding() * memory_chunk::alignement(),
                 "Padding not correct");
 };
 
@@ -0,0 +1,203 @@
+/** @file poolArena.hpp
+ *  @brief Pools shared by every allocator of a node-based container
+ *
+ *  Containers rebind their allocator to their nodes (and buckets, maps...).
+ *  An ArenaAllocator is a handle on a PoolArena: every rebound copy draws
+ *  from the pool of its size class in the same arena, instead of owning a
+ *  fresh pool of its own
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef poolArena_hpp
+#define poolArena_hpp
+
+#include "generalAllocator.hpp"
+#include "poolAllocator.hpp"
+
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+
+namespace _fmmAllocator {
+
+namespace detail {
+
+/// @brief Storage for one element of \ref _Size bytes aligned to \ref _Align
+template <std::size_t _Size, std::size_t _Align>
+struct alignas(_Align) ArenaCell {
+  unsigned char bytes[_Size];
+};
+
+/// @brief Size class of \ref _Tp: its size rounded up to whole pool slots
+template <typename _Tp> struct arena_cell {
+  static constexpr std::size_t align = MemoryChunk<_Tp>::alignement();
+  typedef ArenaCell<(sizeof(_Tp) + align - 1) / align * align, align> type;
+};
+
+} // namespace detail
+
+/// @brief
+/// The pools behind the \ref ArenaAllocator handles, one per size class (see
+/// detail::arena_cell): types of the same rounded size and alignment share a
+/// pool. Pools are created on first use and live as long as the arena
+///
+/// NOTE: Like its pools (see PoolAllocator::set_owner), an arena has no owner:
+/// the caller serializes every (de)allocation
+template <std::size_t _Block_Size, bool _Recycle_Slots = false,
+          class _Block_Source = HeapBlockSource>
+class PoolArena {
+public:
+  template <typename _Tp>
+  using pool_type = PoolAllocator<typename detail::arena_cell<_Tp>::type,
+                                  _Block_Size, _Recycle_Slots,
+                                  detail::size_classes(_Block_Size),
+                                  _Block_Source>;
+
+  PoolArena() = default;
+
+  PoolArena(const PoolArena &) = delete;
+  PoolArena &operator=(const PoolArena &) = delete;
+
+  /// @brief The pool of the size class of \ref _Tp
+  template <typename _Tp> pool_type<_Tp> &pool() {
+    Pool &pool = pools_[std::type_index(typeid(pool_type<_Tp>))];
+    if (!pool.pool_) {
+      pool.pool_ = std::make_shared<pool_type<_Tp>>();
+      pool.blocks_ = [](const void *pool) {
+        return static_cast<const pool_type<_Tp> *>(pool)->blocks();
+      };
+    }
+    return *static_cast<pool_type<_Tp> *>(pool.pool_.get());
+  }
+
+  /// @brief Number of size classes in use
+  std::size_t pools() const { return pools_.size(); }
+
+  /// @brief Number of blocks held by all the pools
+  std::size_t blocks() const {
+    std::size_t n = 0;
+    for (const auto &pool : pools_) {
+      n += pool.second.blocks_(pool.second.pool_.get());
+    }
+    return n;
+  }
+
+private:
+  /// @brief A pool of any size class
+  struct Pool {
+    std::shared_ptr<void> pool_;
+    std::size_t (*blocks_)(const void *) = nullptr;
+  };
+
+  std::map<std::type_index, Pool> pools_;
+};
+
+/// @brief
+/// STL compatible handle on a shared \ref PoolArena. Copies, rebound copies
+/// included, share the arena and compare equal; the arena goes away with the
+/// last handle. Containers propagate the handle on copy and move assignment
+/// and on swap, so their nodes always go back to the arena they came from
+///
+/// NOTE: Moves copy, so that a moved-from container may still allocate
+template <typename _Tp, std::size_t _Block_Size, bool _Recycle_Slots = false,
+          class _Block_Source = HeapBlockSource>
+class ArenaAllocator : public GeneralAllocator<_Tp> {
+public:
+  using value_type = _Tp;
+  using reference = _Tp &;
+  using const_reference = const _Tp &;
+  using pointer = _Tp *;
+  using const_pointer = const _Tp *;
+
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  using arena_type = PoolArena<_Block_Size, _Recycle_Slots, _Block_Source>;
+  using pool_allocator = typename arena_type::template pool_type<_Tp>;
+
+  template <typename _Up> struct rebind {
+    typedef ArenaAllocator<_Up, _Block_Size, _Recycle_Slots, _Block_Source>
+        other;
+  };
+
+  /// @brief Default ctor: creates a new arena
+  ArenaAllocator() : ArenaAllocator(std::make_shared<arena_type>()) {}
+
+  /// @brief Handle on \ref arena
+  explicit ArenaAllocator(std::shared_ptr<arena_type> arena)
+      : arena_(std::move(arena)) {}
+
+  ArenaAllocator(const ArenaAllocator &) = default;
+  ArenaAllocator &operator=(const ArenaAllocator &) = default;
+
+  /// @brief Rebinding: the same arena, the pool of the size class of \ref _Tp
+  template <typename _Up>
+  ArenaAllocator(
+      const ArenaAllocator<_Up, _Block_Size, _Recycle_Slots, _Block_Source>
+          &other)
+      : ArenaAllocator(other.arena_) {}
+
+  /// @brief Allocates memory
+  pointer allocate(std::size_t count, const void * = nullptr) {
+    return reinterpret_cast<pointer>(pool().allocate(cells(count)));
+  }
+
+  /// @brief Deallocates memory
+  void deallocate(pointer ptr, std::size_t count) {
+    pool().deallocate(
+        reinterpret_cast<typename pool_allocator::pointer>(ptr),
+        cells(count));
+  }
+
+  const std::shared_ptr<arena_type> &arena() const { return arena_; }
+
+  /// @brief The pool of the size class of \ref _Tp
+  /// NOTE: Looked up on first use: a container never allocates from the pool
+  /// of the handle it was given when it only allocates nodes
+  pool_allocator &pool() const {
+    if (unlikely(pool_ == nullptr)) {
+      pool_ = &arena_->template pool<_Tp>();
+    }
+    return *pool_;
+  }
+
+  template <typename _Up>
+  bool operator==(
+      const ArenaAllocator<_Up, _Block_Size, _Recycle_Slots, _Block_Source>
+          &other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <typename _Up>
+  bool operator!=(
+      const ArenaAllocator<_Up, _Block_Size, _Recycle_Slots, _Block_Source>
+          &other) const {
+    return arena_ != other.arena_;
+  }
+
+private:
+  template <typename _Up, std::size_t, bool, class>
+  friend class ArenaAllocator;
+
+  using cell = typename detail::arena_cell<_Tp>::type;
+
+  /// @brief Number of cells spanned by \ref count elements
+  /// NOTE: An array of elements smaller than a cell is packed
+  static constexpr std::size_t cells(std::size_t count) {
+    return sizeof(cell) == sizeof(_Tp)
+               ? count
+               : (count * sizeof(_Tp) + sizeof(cell) - 1) / sizeof(cell);
+  }
+
+  std::shared_ptr<arena_type> arena_;
+  mutable pool_allocator *pool_ = nullptr;
+};
+
+} // namespace _fmmAllocator
+#endif /* poolArena_hpp */
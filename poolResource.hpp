@@ -0,0 +1,238 @@
+/** @file poolResource.hpp
+ *  @brief std::pmr::memory_resource on top of the pools
+ *
+ *  Requests of any size and alignment are mapped onto counts of pool slots.
+ *  Small counts are rounded up to a size class with a pool of its own, where
+ *  a request takes a single slot of that size. Larger ones are free chunks
+ *  of a pool of one-slot elements, and the largest ones get their own
+ *  mapping (see PoolAllocator::allocate)
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef poolResource_hpp
+#define poolResource_hpp
+
+#include "poolAllocator.hpp"
+#include "poolArena.hpp"
+
+#include <cstdint>
+#include <memory_resource>
+#include <tuple>
+#include <utility>
+
+namespace _fmmAllocator {
+
+namespace detail {
+
+/// @brief Slots of the size class \ref __class of a PoolResource: 1 to 8
+/// slots, then four classes per doubling (10, 12, 14, 16, 20, 24...)
+constexpr std::size_t resource_class_slots(std::size_t __class) {
+  return __class < 8 ? __class + 1
+                     : (5 + (__class - 8) % 4) << (1 + (__class - 8) / 4);
+}
+
+/// @brief Size class of a request of \ref __slots slots
+constexpr std::size_t resource_class(std::size_t __slots) {
+  return __slots <= 8
+             ? __slots - 1
+             : 8 + 4 * (log2_floor(__slots - 1) - 3) +
+                   ((__slots - 1) >> (log2_floor(__slots - 1) - 2)) - 4;
+}
+
+/// @brief The tuple of the pools of the size classes in \ref _Sequence
+template <template <std::size_t> class _Pool, class _Sequence>
+struct resource_pools;
+
+template <template <std::size_t> class _Pool, std::size_t... _Is>
+struct resource_pools<_Pool, std::index_sequence<_Is...>> {
+  typedef std::tuple<_Pool<resource_class_slots(_Is)>...> type;
+};
+
+} // namespace detail
+
+/// @brief
+/// A memory_resource drawing from \ref PoolAllocator pools: one per size
+/// class of up to \ref _Small_Slots slots (a power of two, at least 8), and
+/// one of single slots whose free chunks serve the larger requests.
+/// Alignments up to a slot come for free; larger ones take \ref slot_size +
+/// alignment bytes more (the unaligned pointer is kept right before the
+/// aligned one).
+///
+/// It may be the upstream of a std::pmr::unsynchronized_pool_resource.
+///
+/// NOTE: Like its pools (see PoolAllocator::set_owner), a resource has no
+/// owner: the caller serializes every (de)allocation
+///
+/// NOTE: A larger request that takes a new block may first fold back the
+/// slots left over by the earlier ones (see \ref recycle_period), which sorts
+/// every free piece of the large pool. Latency sensitive callers avoid that
+/// spike by calling \ref trim at quiet times
+template <std::size_t _Block_Size, bool _Recycle_Slots = false,
+          class _Block_Source = HeapBlockSource,
+          std::size_t _Small_Slots = 64>
+class PoolResource : public std::pmr::memory_resource {
+public:
+  /// @brief Bytes of a pool slot: requests are rounded up to whole slots
+  static constexpr std::size_t slot_size =
+      detail::MemoryChunk<void *>::alignement();
+
+  /// @brief Number of size classes with a pool of their own
+  static constexpr std::size_t small_classes =
+      detail::resource_class(_Small_Slots) + 1;
+
+  static_assert(_Small_Slots >= 8 && (_Small_Slots & (_Small_Slots - 1)) == 0,
+                "The small requests must span a power of two of slots");
+
+  /// @brief The pool of the requests of \ref _Slots slots
+  template <std::size_t _Slots>
+  using pool_type =
+      PoolAllocator<detail::ArenaCell<_Slots * slot_size, slot_size>,
+                    _Block_Size, _Recycle_Slots,
+                    detail::size_classes(_Block_Size), _Block_Source>;
+
+private:
+  using small_pools = typename detail::resource_pools<
+      pool_type, std::make_index_sequence<small_classes>>::type;
+
+public:
+  PoolResource() = default;
+
+  PoolResource(const PoolResource &) = delete;
+  PoolResource &operator=(const PoolResource &) = delete;
+
+  /// @brief The pool of the size class \ref _Class
+  template <std::size_t _Class>
+  typename std::tuple_element<_Class, small_pools>::type &pool() {
+    return std::get<_Class>(pools_);
+  }
+
+  /// @brief The pool of the requests of more than \ref _Small_Slots slots
+  pool_type<1> &large_pool() { return large_; }
+
+  /// @brief Folds back the slots left over by the larger requests and gives
+  /// the empty blocks of every pool back to the system (see
+  /// PoolAllocator::trim). Returns the number of blocks released
+  std::size_t trim() {
+    large_frees_ = 0;
+    std::size_t released = large_.trim();
+    std::apply(
+        [&released](auto &... pools) { ((released += pools.trim()), ...); },
+        pools_);
+    return released;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (likely(alignment <= slot_size)) {
+      return allocate_slots(slots(bytes));
+    }
+    char *const raw =
+        static_cast<char *>(allocate_slots(slots(bytes + alignment)));
+    void **const aligned = reinterpret_cast<void **>(
+        (reinterpret_cast<std::uintptr_t>(raw) + slot_size + alignment - 1) &
+        ~(alignment - 1));
+    aligned[-1] = raw;
+    return aligned;
+  }
+
+  void do_deallocate(void *ptr, std::size_t bytes,
+                     std::size_t alignment) override {
+    if (likely(alignment <= slot_size)) {
+      deallocate_slots(ptr, slots(bytes));
+      return;
+    }
+    deallocate_slots(static_cast<void **>(ptr)[-1],
+                     slots(bytes + alignment));
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+  /// @brief Number of slots spanned by \ref bytes (at least one)
+  static constexpr std::size_t slots(std::size_t bytes) {
+    return bytes > slot_size ? (bytes + slot_size - 1) / slot_size : 1;
+  }
+
+  DEQUE_INLINE void *allocate_slots(std::size_t count) {
+    if (likely(count <= _Small_Slots)) {
+      return allocate_small(detail::resource_class(count),
+                            std::make_index_sequence<small_classes>());
+    }
+    return allocate_large(count);
+  }
+
+  /// @brief A free chunk of \ref count slots of \ref large_
+  void *allocate_large(std::size_t count) {
+    const std::size_t blocks = large_.blocks();
+    auto ptr = large_.allocate(count);
+    if (unlikely(large_.blocks() != blocks) &&
+        large_frees_ >= recycle_period) {
+      // The new block may not have been needed: fold the slots left over
+      // back and try again
+      large_frees_ = 0;
+      large_.deallocate(ptr, count);
+      large_.recycle_slots();
+      ptr = large_.allocate(count);
+    }
+    return ptr;
+  }
+
+  DEQUE_INLINE void deallocate_slots(void *ptr, std::size_t count) {
+    if (likely(count <= _Small_Slots)) {
+      deallocate_small(ptr, detail::resource_class(count),
+                       std::make_index_sequence<small_classes>());
+      return;
+    }
+    large_.deallocate(static_cast<typename pool_type<1>::pointer>(ptr),
+                      count);
+    ++large_frees_;
+  }
+
+  /// @brief A single slot of the pool of the size class \ref size_class
+  template <std::size_t... _Is>
+  DEQUE_INLINE void *allocate_small(std::size_t size_class,
+                                    std::index_sequence<_Is...>) {
+    using allocate_fn = void *(*)(small_pools &);
+    static constexpr allocate_fn table[] = {&allocate_from<_Is>...};
+    return table[size_class](pools_);
+  }
+
+  template <std::size_t... _Is>
+  DEQUE_INLINE void deallocate_small(void *ptr, std::size_t size_class,
+                                     std::index_sequence<_Is...>) {
+    using deallocate_fn = void (*)(small_pools &, void *);
+    static constexpr deallocate_fn table[] = {&deallocate_to<_Is>...};
+    table[size_class](pools_, ptr);
+  }
+
+  template <std::size_t _I> static void *allocate_from(small_pools &pools) {
+    return std::get<_I>(pools).allocate(1);
+  }
+
+  template <std::size_t _I>
+  static void deallocate_to(small_pools &pools, void *ptr) {
+    using pool = typename std::tuple_element<_I, small_pools>::type;
+    std::get<_I>(pools).deallocate(static_cast<typename pool::pointer>(ptr),
+                                   1);
+  }
+
+  /// Larger requests split the free chunks of \ref large_, and leave the
+  /// slots too few to make a chunk behind as single slots that no request of
+  /// its own reuses. They are folded back by \ref trim, or when \ref large_
+  /// takes a new block at least \ref recycle_period frees after the last time
+  /// NOTE: The fold costs O(n log n) in the free pieces of \ref large_, all
+  /// of it on that one allocation. A \ref trim restarts the count
+  static constexpr std::size_t recycle_period = 4096;
+
+  small_pools pools_;
+  pool_type<1> large_;
+  std::size_t large_frees_ = 0;
+};
+
+} // namespace _fmmAllocator
+#endif /* poolResource_hpp */
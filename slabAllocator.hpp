@@ -0,0 +1,401 @@
+/** @file slabAllocator.hpp
+ *  @brief Slab allocator with out-of-band bitmaps
+ *
+ *  An alternative to the free lists of the PoolAllocator: each block (a slab)
+ *  only starts with a pointer to its descriptor, which holds a bitmap of the
+ *  slots in use. Runs of free slots are found with ctz, freeing clears bits,
+ *  and neighbouring free slots are merged by construction
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef slabAllocator_hpp
+#define slabAllocator_hpp
+
+#include "blockSource.hpp"
+#include "generalAllocator.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace _fmmAllocator {
+
+/// @brief
+/// The SlabAllocator hands out runs of consecutive slots of \ref _Tp from
+/// blocks of \ref _Block_Size bytes, taken from a \ref _Block_Source and
+/// aligned to their size. Each block is a slab: its occupancy is a bitmap
+/// (one bit per slot) kept in a descriptor outside the block, found through
+/// the single pointer at the start of the block. Free slots carry no header
+/// and take part in no list: a run of \ref count elements takes any \ref count
+/// neighbouring free slots, whichever allocations freed them.
+///
+/// The slabs with free slots are themselves a bitmap: allocating tries the
+/// slab of the last allocation first, then the others in order (first fit).
+/// Empty slabs are kept until \ref trim. Allocations of more than
+/// \ref max_count elements get their own mapping (see \ref LargeBlockSource).
+///
+/// NOTE: Not thread-safe: a slab allocator belongs to the thread that uses it
+template <typename _Tp, std::size_t _Block_Size,
+          class _Block_Source = HeapBlockSource>
+class SlabAllocator : public GeneralAllocator<_Tp> {
+  /// Bytes before the first slot of a block: the pointer to its slab
+  static constexpr std::size_t header_bytes =
+      (sizeof(void *) + alignof(_Tp) - 1) / alignof(_Tp) * alignof(_Tp);
+
+  static constexpr std::size_t n_slots =
+      _Block_Size > header_bytes ? (_Block_Size - header_bytes) / sizeof(_Tp)
+                                 : 0;
+
+  static constexpr std::size_t digits = 64;
+  static constexpr std::size_t n_words = (n_slots + digits - 1) / digits;
+
+  /// @brief The descriptor of a block: bit i of \ref used_ is set if the
+  /// slot i is in use (and so are the bits past the last slot)
+  struct Slab {
+    char *block_;
+    /// Number of free slots
+    std::size_t free_;
+    /// Index in \ref slabs_
+    std::size_t index_;
+    /// No word before this one has a free slot
+    std::size_t hint_;
+    /// No run of free slots is longer (an upper bound, set when a search
+    /// fails and lifted by any free)
+    std::size_t longest_;
+    std::uint64_t used_[n_words];
+  };
+
+public:
+  using value_type = _Tp;
+  using reference = _Tp &;
+  using const_reference = const _Tp &;
+  using pointer = _Tp *;
+  using const_pointer = const _Tp *;
+
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::false_type is_always_equal;
+
+  using block_source = _Block_Source;
+
+  template <typename _Up> struct rebind {
+    typedef SlabAllocator<_Up, _Block_Size, _Block_Source> other;
+  };
+
+  /// @brief Number of slots of a block
+  static constexpr std::size_t slots_in_block() { return n_slots; }
+
+  /// @brief Maximum number of elements a single allocation may request
+  static constexpr std::size_t max_count() { return n_slots; }
+
+  SlabAllocator() = default;
+
+  SlabAllocator(const SlabAllocator &) = delete;
+  SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+  ~SlabAllocator() {
+    for (const auto &slab : slabs_) {
+      source_.deallocate(slab->block_, _Block_Size, _Block_Size);
+    }
+  }
+
+  /// @brief Allocates memory
+  pointer allocate(std::size_t count, const void * = nullptr) {
+    if (unlikely(count > max_count())) {
+      if (unlikely(count > this->max_size())) {
+        throw std::length_error("Requested too many allocations");
+      }
+      return allocate_large(count);
+    }
+    if (likely(current_ != nullptr)) {
+      if (pointer ptr = take(*current_, count)) {
+        return ptr;
+      }
+    }
+    return allocate_slow(count);
+  }
+
+  /// @brief Deallocates memory: clears the bits of its slots
+  void deallocate(pointer ptr, std::size_t count) {
+    if (unlikely(count > max_count())) {
+      deallocate_large(ptr, count);
+      return;
+    }
+    Slab &slab = slab_of(ptr);
+    const std::size_t first = static_cast<std::size_t>(
+        (reinterpret_cast<char *>(ptr) - slab.block_ - header_bytes) /
+        sizeof(_Tp));
+    mark(slab, first, count, false);
+    if (slab.free_ == 0) {
+      set_available(slab.index_, true);
+    }
+    slab.free_ += count;
+    slab.hint_ = std::min(slab.hint_, first / digits);
+    slab.longest_ = n_slots;
+  }
+
+  /// @brief Gives the empty slabs back to the block source until at most
+  /// \ref keep are left. Returns the number of blocks released
+  std::size_t trim(std::size_t keep = 0) {
+    std::size_t empty = 0, released = 0;
+    for (std::size_t i = 0; i < slabs_.size();) {
+      if (slabs_[i]->free_ != n_slots || ++empty <= keep) {
+        ++i;
+        continue;
+      }
+      remove_slab(i);
+      ++released;
+    }
+    return released;
+  }
+
+  /// @brief Number of blocks held
+  std::size_t blocks() const { return slabs_.size(); }
+
+  /// @brief Number of free slots in the blocks held
+  std::size_t free_slots() const {
+    std::size_t count = 0;
+    for (const auto &slab : slabs_) {
+      count += slab->free_;
+    }
+    return count;
+  }
+
+  /// @brief Number of slots in use, counted from the bitmaps
+  std::size_t slots_in_use() const {
+    std::size_t count = 0;
+    for (const auto &slab : slabs_) {
+      for (std::uint64_t word : slab->used_) {
+        count += detail::popcount(word);
+      }
+      count -= n_words * digits - n_slots;
+    }
+    return count;
+  }
+
+  /// @brief Where the blocks come from
+  block_source &get_block_source() { return source_; }
+
+  /// @brief An allocator owns its slabs: no other one frees its elements
+  bool operator==(const SlabAllocator &other) const { return this == &other; }
+
+  bool operator!=(const SlabAllocator &other) const { return this != &other; }
+
+private:
+  static constexpr std::size_t npos = std::size_t(-1);
+
+  /// @brief Takes \ref count free slots in a row from \ref slab. Returns
+  /// nullptr if it has none
+  DEQUE_INLINE pointer take(Slab &slab, std::size_t count) {
+    if (slab.free_ < count || slab.longest_ < count) {
+      return nullptr;
+    }
+    const std::size_t first =
+        count == 1 ? find_slot(slab) : find_run(slab, count);
+    if (first == npos) {
+      slab.longest_ = count - 1;
+      return nullptr;
+    }
+    mark(slab, first, count, true);
+    slab.free_ -= count;
+    if (slab.free_ == 0) {
+      set_available(slab.index_, false);
+    }
+    return reinterpret_cast<pointer>(slab.block_ + header_bytes +
+                                     first * sizeof(_Tp));
+  }
+
+  /// @brief Tries the other slabs with free slots, in order, then a new one
+  pointer allocate_slow(std::size_t count) {
+    for (std::size_t w = 0; w < available_.size(); ++w) {
+      for (std::uint64_t bits = available_[w]; bits != 0; bits &= bits - 1) {
+        Slab &slab = *slabs_[w * digits + detail::count_trailing_zeros(bits)];
+        if (&slab == current_) {
+          continue;
+        }
+        if (pointer ptr = take(slab, count)) {
+          current_ = &slab;
+          return ptr;
+        }
+      }
+    }
+    current_ = &new_slab();
+    return take(*current_, count);
+  }
+
+  /// @brief Index of the first free slot of \ref slab (which has one)
+  DEQUE_INLINE static std::size_t find_slot(Slab &slab) {
+    skip_full_words(slab);
+    return slab.hint_ * digits +
+           detail::count_trailing_zeros(~slab.used_[slab.hint_]);
+  }
+
+  /// @brief Index of the first run of \ref count free slots of \ref slab, or
+  /// npos. The free bits at the top of a word carry over to the next one
+  static std::size_t find_run(Slab &slab, std::size_t count) {
+    skip_full_words(slab);
+    std::size_t run = 0;
+    for (std::size_t w = slab.hint_; w < n_words; ++w) {
+      const std::uint64_t used = slab.used_[w];
+      if (used == 0) {
+        run += digits;
+        if (run >= count) {
+          return (w + 1) * digits - run;
+        }
+        continue;
+      }
+      if (run + detail::count_trailing_zeros(used) >= count) {
+        return w * digits - run;
+      }
+      if (count <= digits) {
+        const std::uint64_t starts = run_starts(~used, count);
+        if (starts != 0) {
+          return w * digits + detail::count_trailing_zeros(starts);
+        }
+      }
+      run = digits - 1 - detail::log2_floor(used);
+    }
+    return npos;
+  }
+
+  /// @brief Bit i is set if the bits i to i + \ref count - 1 of \ref free
+  /// are (doubling the length of the runs at each step)
+  DEQUE_INLINE static std::uint64_t run_starts(std::uint64_t free,
+                                               std::size_t count) {
+    for (std::size_t length = 1; length < count;) {
+      const std::size_t shift = std::min(length, count - length);
+      free &= free >> shift;
+      length += shift;
+    }
+    return free;
+  }
+
+  /// @brief Moves the hint of \ref slab past its leading full words
+  DEQUE_INLINE static void skip_full_words(Slab &slab) {
+    while (slab.hint_ < n_words &&
+           slab.used_[slab.hint_] == ~std::uint64_t(0)) {
+      ++slab.hint_;
+    }
+  }
+
+  /// @brief Sets (or clears) the bits of the \ref count slots from \ref first
+  DEQUE_INLINE static void mark(Slab &slab, std::size_t first,
+                                std::size_t count, bool used) {
+    while (count > 0) {
+      const std::size_t bit = first % digits;
+      const std::size_t n = std::min(count, digits - bit);
+      const std::uint64_t mask =
+          (n == digits ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1)
+          << bit;
+      if (used) {
+        slab.used_[first / digits] |= mask;
+      } else {
+        slab.used_[first / digits] &= ~mask;
+      }
+      first += n;
+      count -= n;
+    }
+  }
+
+  /// @brief The slab of the block holding \ref ptr (blocks are aligned to
+  /// their size)
+  DEQUE_INLINE static Slab &slab_of(const void *ptr) {
+    return **reinterpret_cast<Slab **>(reinterpret_cast<std::uintptr_t>(ptr) &
+                                       ~(_Block_Size - 1));
+  }
+
+  /// @brief Takes a block from the source, all of its slots free
+  Slab &new_slab() {
+    POOL_EVENT(new_block, 1)
+    std::unique_ptr<Slab> slab(new Slab());
+    slab->block_ =
+        static_cast<char *>(source_.allocate(_Block_Size, _Block_Size));
+    slab->free_ = n_slots;
+    slab->index_ = slabs_.size();
+    slab->hint_ = 0;
+    slab->longest_ = n_slots;
+    if (n_slots % digits != 0) {
+      slab->used_[n_words - 1] = ~std::uint64_t(0) << (n_slots % digits);
+    }
+    *reinterpret_cast<Slab **>(slab->block_) = slab.get();
+
+    slabs_.push_back(std::move(slab));
+    available_.resize((slabs_.size() + digits - 1) / digits);
+    set_available(slabs_.size() - 1, true);
+    return *slabs_.back();
+  }
+
+  /// @brief Gives the block of the slab \ref index back, moving the last slab
+  /// to its place
+  void remove_slab(std::size_t index) {
+    POOL_EVENT(release_block, 1)
+    if (slabs_[index].get() == current_) {
+      current_ = nullptr;
+    }
+    source_.deallocate(slabs_[index]->block_, _Block_Size, _Block_Size);
+
+    const std::size_t last = slabs_.size() - 1;
+    set_available(index, slabs_[last]->free_ > 0);
+    set_available(last, false);
+    slabs_[index] = std::move(slabs_[last]);
+    slabs_[index]->index_ = index;
+    slabs_.pop_back();
+    available_.resize((slabs_.size() + digits - 1) / digits);
+  }
+
+  DEQUE_INLINE void set_available(std::size_t index, bool available) {
+    const std::uint64_t bit = std::uint64_t(1) << (index % digits);
+    if (available) {
+      available_[index / digits] |= bit;
+    } else {
+      available_[index / digits] &= ~bit;
+    }
+  }
+
+  /// @brief Bytes actually mapped for \ref count elements past \ref max_count
+  static std::size_t large_size(std::size_t count) {
+    const std::size_t page = detail::page_size();
+    return (count * sizeof(_Tp) + page - 1) / page * page;
+  }
+
+  static std::size_t large_alignment() {
+    return std::max(detail::page_size(), alignof(_Tp));
+  }
+
+  pointer allocate_large(std::size_t count) {
+    POOL_EVENT(large_map, 1)
+    return static_cast<pointer>(
+        large_source_.allocate(large_size(count), large_alignment()));
+  }
+
+  void deallocate_large(pointer ptr, std::size_t count) {
+    POOL_EVENT(large_unmap, 1)
+    large_source_.deallocate(static_cast<void *>(ptr), large_size(count),
+                             large_alignment());
+  }
+
+  /// The slabs, in no particular order (see \ref Slab::index_)
+  std::vector<std::unique_ptr<Slab>> slabs_;
+
+  /// Bit i is set if the slab i has free slots
+  std::vector<std::uint64_t> available_;
+
+  /// The slab of the last allocation, tried first
+  Slab *current_ = nullptr;
+
+  block_source source_;
+  LargeBlockSource large_source_;
+
+  static_assert(!(_Block_Size & (_Block_Size - 1)),
+                "_Block_Size not a power of 2");
+  static_assert(n_slots >= 2, "_Block_Size trivially small");
+};
+
+} // namespace _fmmAllocator
+#endif /* slabAllocator_hpp */
@@ -0,0 +1,145 @@
+//
+//  test_alignment.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_alignment_h
+#define test_alignment_h
+
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// Whether \ref ptr is aligned to \ref alignment
+inline bool is_aligned(const void *ptr, std::size_t alignment) {
+	return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+/// Allocates single elements, runs, bulks and large arrays, checking that
+/// every one is aligned to \ref alignment and holds its values
+template<typename _Allocator>
+int aligned_allocations(_Allocator &allocator, std::size_t alignment) {
+	using value_type = typename _Allocator::value_type;
+	const std::size_t counts[] = {1, 2, 3, 7, _Allocator::max_count(),
+								  _Allocator::max_count() + 1};
+
+	std::vector<std::pair<value_type *, std::size_t>> ptrs;
+	for (int round = 0; round < 4; ++round) {
+		for (std::size_t count : counts) {
+			value_type *ptr = allocator.allocate(count);
+			if (!is_aligned(ptr, alignment)) {
+				return 0;
+			}
+			for (std::size_t i = 0; i < count; ++i) {
+				ptr[i].value = static_cast<int>(count + i);
+			}
+			ptrs.emplace_back(ptr, count);
+		}
+	}
+
+	value_type *bulk[16];
+	allocator.allocate_bulk(bulk, 16);
+	for (value_type *ptr : bulk) {
+		if (!is_aligned(ptr, alignment)) {
+			return 0;
+		}
+	}
+	allocator.deallocate_bulk(bulk, 16);
+
+	for (std::size_t i = 0; i < ptrs.size(); i += 2) {
+		allocator.deallocate(ptrs[i].first, ptrs[i].second);
+	}
+	for (std::size_t i = 1; i < ptrs.size(); i += 2) {
+		for (std::size_t j = 0; j < ptrs[i].second; ++j) {
+			if (ptrs[i].first[j].value != static_cast<int>(ptrs[i].second + j)) {
+				return 0;
+			}
+		}
+		allocator.deallocate(ptrs[i].first, ptrs[i].second);
+	}
+	return 1;
+}
+
+/// Test for over-aligned types and for slots padded to whole cache lines
+template<std::size_t _BlockSize, bool _Recycle_Slots>
+int alignment_usage() {
+
+	struct alignas(64) Line {
+		int value;
+	};
+	struct alignas(4096) Page {
+		int value;
+	};
+	struct Small {
+		int value;
+	};
+
+	// A chunk header fits in a single slot of 64 bytes
+	using LineAllocator = PoolAllocator<Line, _BlockSize, _Recycle_Slots>;
+	if (LineAllocator::memory_chunk::padding() != 1 ||
+		LineAllocator::slots_in_block() !=
+			_BlockSize / 64 - LineAllocator::header_slots() - 1) {
+		return 0;
+	}
+	LineAllocator lines;
+	if (!aligned_allocations(lines, 64)) {
+		return 0;
+	}
+
+	// Page-aligned slots, and large arrays aligned beyond a page
+	using PageAllocator = PoolAllocator<Page, 16 * _BlockSize, _Recycle_Slots>;
+	PageAllocator pages;
+	if (!aligned_allocations(pages, 4096)) {
+		return 0;
+	}
+	using HugeAllocator =
+		PoolAllocator<detail::ArenaCell<8192, 8192>, 32 * _BlockSize>;
+	HugeAllocator huge;
+	for (int i = 0; i < 8; ++i) {
+		auto *ptr = huge.allocate(HugeAllocator::max_count() + 1);
+		if (!is_aligned(ptr, 8192)) {
+			return 0;
+		}
+		huge.deallocate(ptr, HugeAllocator::max_count() + 1);
+	}
+
+	// Padded to cache lines: no two allocations share a line
+	using PaddedAllocator =
+		PoolAllocator<Small, _BlockSize, _Recycle_Slots,
+					  detail::size_classes(_BlockSize), HeapBlockSource,
+					  FixedGrowth, detail::cache_line>;
+	static_assert(sizeof(typename PaddedAllocator::slot) == detail::cache_line,
+				  "A padded slot takes a whole cache line");
+	PaddedAllocator padded;
+	if (!aligned_allocations(padded, detail::cache_line)) {
+		return 0;
+	}
+	Small *first = padded.allocate(1), *second = padded.allocate(1);
+	Small *run = padded.allocate(3), *third = padded.allocate(1);
+	const auto line = [](const void *ptr) {
+		return reinterpret_cast<std::uintptr_t>(ptr) / detail::cache_line;
+	};
+	if (line(first) == line(second) || line(run) == line(first) ||
+		line(run + 2) == line(third) || line(run) != line(run + 2)) {
+		return 0;
+	}
+	padded.deallocate(first, 1);
+	padded.deallocate(second, 1);
+	padded.deallocate(run, 3);
+	padded.deallocate(third, 1);
+
+	// The padding mode survives a rebind
+	typename PaddedAllocator::template rebind<double>::other doubles;
+	double *x = doubles.allocate(1), *y = doubles.allocate(1);
+	if (line(x) == line(y)) {
+		return 0;
+	}
+	doubles.deallocate(x, 1);
+	doubles.deallocate(y, 1);
+	return 1;
+}
+
+#endif /* test_alignment_h */
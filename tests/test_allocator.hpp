@@ -10,11 +10,16 @@
 
 #include "test_util.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <random>
 
 /// Test for rapid allocation and deallocation
-template <typename _Type, std::size_t _BlockSize> int pool_usage() {
+/// Each allocation requests between 1 and \ref max_count elements
+template <typename _Type, std::size_t _BlockSize,
+          typename _Allocator = ALLOCATOR(_Type, _BlockSize)>
+int pool_usage(std::size_t max_count = 1) {
   std::cout << "Testing Allocator:\t\t" << std::flush;
 
   // NOTE: Does it prevent undesirable optimizations?
@@ -25,40 +30,133 @@ template <typename _Type, std::size_t _BlockSize> int pool_usage() {
       1 << 14; // "real" max will be sqrt(max). Reason: nested for loops
   assert(max <= n_allocations);
 
-  ALLOCATOR(_Type, _BlockSize) allocator;
+  _Allocator allocator;
 
   std::vector<void *> ptrs;
   ptrs.reserve(n_allocations);
 
+  std::vector<std::size_t> counts(n_allocations);
   for (std::size_t i = 0; i < n_allocations; ++i) {
-    ptrs.push_back(allocator.allocate(1));
+    counts[i] = 1 + i % max_count;
+    ptrs.push_back(allocator.allocate(counts[i]));
   }
 
+  std::mt19937 generator{};
+
   // deallocate and allocate random number of elements!
   for (std::size_t i = 0; i < std::sqrt(max); ++i) {
 
-    // shuffle pointer list
-    std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{});
-
     const std::size_t random_int =
         min +
         (std::rand() % static_cast<std::size_t>(std::sqrt(max) - min + 1));
 
+    // partially shuffle the pointer list (and the matching counts): only the
+    // first random_int pointers need to be a random pick
     for (std::size_t j = 0; j < random_int; ++j) {
-      allocator.deallocate(static_cast<_Type *>(ptrs[j]), 1);
+      std::uniform_int_distribution<std::size_t> pick(j, n_allocations - 1);
+      const std::size_t k = pick(generator);
+      std::swap(ptrs[j], ptrs[k]);
+      std::swap(counts[j], counts[k]);
+    }
+
+    for (std::size_t j = 0; j < random_int; ++j) {
+      allocator.deallocate(static_cast<_Type *>(ptrs[j]), counts[j]);
       ptrs[j] = nullptr;
     }
 
     for (std::size_t j = 0; j < random_int; ++j) {
-      ptrs[j] = allocator.allocate(1);
+      ptrs[j] = allocator.allocate(counts[j]);
     }
   }
 
-  for (auto ptr : ptrs)
-    allocator.deallocate(static_cast<_Type *>(ptr), 1);
+  for (std::size_t i = 0; i < n_allocations; ++i)
+    allocator.deallocate(static_cast<_Type *>(ptrs[i]), counts[i]);
 
   std::cout << "SUCCESS" << std::endl;
   return 1;
 };
 
+/// Test for the single slot free list: LIFO reuse and no per slot padding
+template <typename _Type, std::size_t _BlockSize> int slot_usage() {
+  std::cout << "Testing Single Slots:\t\t" << std::flush;
+
+  PoolAllocator<_Type, _BlockSize> allocator;
+
+  // consecutive single slots are packed back to back
+  _Type *first = allocator.allocate(1);
+  _Type *second = allocator.allocate(1);
+  if (second != first + 1) {
+    return 0;
+  }
+
+  // the last freed slot is the first one handed out again
+  allocator.deallocate(first, 1);
+  allocator.deallocate(second, 1);
+  if (allocator.allocate(1) != second || allocator.allocate(1) != first) {
+    return 0;
+  }
+
+  std::cout << "SUCCESS" << std::endl;
+  return 1;
+}
+
+/// Counts its constructions
+struct Counted {
+  Counted() { ++constructed; }
+  double value;
+  static std::size_t constructed;
+};
+std::size_t Counted::constructed = 0;
+
+/// Test for the allocations too large for a block: no element is constructed
+/// and a freed allocation is reused
+template <std::size_t _BlockSize> int large_usage() {
+  std::cout << "Testing Large Allocations:\t" << std::flush;
+
+  using Allocator = PoolAllocator<Counted, _BlockSize>;
+  const std::size_t count = 3 * Allocator::max_count();
+
+  Allocator allocator;
+  Counted *large = allocator.allocate(count);
+  large[count - 1].value = 1.;
+  if (Counted::constructed != 0 || allocator.owns(large)) {
+    return 0;
+  }
+
+  // the same size class gets the spare allocation back
+  allocator.deallocate(large, count);
+  if (allocator.allocate(count - 1) != large) {
+    return 0;
+  }
+  allocator.deallocate(large, count - 1);
+
+  // unless there are no spares
+  allocator.trim();
+  Counted *other = allocator.allocate(Allocator::max_count() + 1);
+  other[Allocator::max_count()].value = 1.;
+  allocator.deallocate(other, Allocator::max_count() + 1);
+
+  // an element larger than a block gets its own mapping, even a single one
+  struct Huge {
+    char bytes[2 * _BlockSize];
+  };
+  PoolAllocator<Huge, _BlockSize> huge_allocator;
+  if (PoolAllocator<Huge, _BlockSize>::max_count() != 0) {
+    return 0;
+  }
+  Huge *huge[3];
+  huge[0] = huge_allocator.allocate(1);
+  huge[0]->bytes[2 * _BlockSize - 1] = 1;
+  if (huge_allocator.owns(huge[0])) {
+    return 0;
+  }
+  huge_allocator.deallocate(huge[0], 1);
+  huge_allocator.allocate_bulk(huge, 3);
+  huge[2]->bytes[2 * _BlockSize - 1] = 1;
+  huge_allocator.deallocate_bulk(huge, 3);
+
+  std::cout << "SUCCESS" << std::endl;
+  return 1;
+}
+
 #endif /* test_allocator_hpp */
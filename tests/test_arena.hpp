@@ -0,0 +1,84 @@
+//
+//  test_arena.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_arena_h
+#define test_arena_h
+
+#include "test_util.hpp"
+
+#include <list>
+#include <map>
+#include <utility>
+
+/// Test for node-based containers sharing the pools of an arena
+template<std::size_t _BlockSize, bool _Recycle_Slots>
+int arena_usage() {
+
+	using IntAllocator = ArenaAllocator<int, _BlockSize, _Recycle_Slots>;
+	using FloatAllocator = typename IntAllocator::template rebind<float>::other;
+	using MapAllocator = typename IntAllocator::template rebind<
+		std::pair<const int, int>>::other;
+
+	std::list<int, IntAllocator> ints;
+	for (int i = 0; i < 10000; ++i) {
+		ints.push_back(i);
+	}
+	const auto arena = ints.get_allocator().arena();
+
+	// Nodes of the same size share a pool, rebound from the same handle
+	std::list<float, FloatAllocator> floats(ints.get_allocator());
+	std::map<int, int, std::less<int>, MapAllocator> map(ints.get_allocator());
+	for (int i = 0; i < 10000; ++i) {
+		floats.push_back(static_cast<float>(i));
+		map.emplace(i, i);
+	}
+	if (!(floats.get_allocator() == ints.get_allocator()) ||
+		arena->pools() != 2) {
+		return 0;
+	}
+
+	// Copies share the arena, a new handle has its own
+	std::list<int, IntAllocator> copy = ints;
+	std::list<int, IntAllocator> other;
+	if (copy.get_allocator() != ints.get_allocator() ||
+		other.get_allocator() == ints.get_allocator()) {
+		return 0;
+	}
+
+	// Assignment propagates the handle: the nodes go back where they came from
+	other.push_back(-1);
+	other = copy;
+	copy.clear();
+	if (other.get_allocator() != ints.get_allocator() ||
+		other.size() != ints.size() || arena->pools() != 2) {
+		return 0;
+	}
+
+	// So does swapping
+	std::list<int, IntAllocator> swapped(3, 7);
+	swapped.swap(other);
+	if (swapped.get_allocator() != ints.get_allocator() ||
+		other.get_allocator() == ints.get_allocator() ||
+		swapped.size() != ints.size()) {
+		return 0;
+	}
+
+	int expected = 0;
+	for (int i : ints) {
+		if (i != expected++) {
+			return 0;
+		}
+	}
+	for (const auto &entry : map) {
+		if (entry.first != entry.second) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+#endif /* test_arena_h */
@@ -0,0 +1,124 @@
+//
+//  test_blockSource.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_blockSource_h
+#define test_blockSource_h
+
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// Test for a pool on top of a given block source
+template<typename _Tp, std::size_t _BlockSize, class _Block_Source>
+int block_source_usage() {
+	
+	using Allocator = PoolAllocator<_Tp, _BlockSize, true,
+		detail::size_classes(_BlockSize), _Block_Source>;
+	const std::size_t count = Allocator::max_count() / 3;
+	const std::size_t size = 12;
+	
+	Allocator allocator;
+	_Tp outsider = _Tp();
+	
+	std::vector<_Tp *> chunks;
+	for (std::size_t i = 0; i < size; ++i) {
+		chunks.push_back(allocator.allocate(count));
+		for (std::size_t j = 0; j < count; ++j) {
+			chunks.back()[j] = _Tp(i);
+		}
+	}
+	
+	// Blocks are aligned to their size, and known to the pool
+	for (auto block : allocator.blocks_) {
+		if (reinterpret_cast<std::uintptr_t>(block) % _BlockSize != 0) {
+			return 0;
+		}
+	}
+	for (std::size_t i = 0; i < size; ++i) {
+		if (!allocator.owns(chunks[i]) || !allocator.owns(chunks[i] + count - 1) ||
+			chunks[i][count - 1] != _Tp(i)) {
+			return 0;
+		}
+	}
+	if (allocator.owns(&outsider)) {
+		return 0;
+	}
+	
+	// Released blocks are given back to the source, then taken again
+	for (auto chunk : chunks) {
+		allocator.deallocate(chunk, count);
+	}
+	allocator.trim();
+	if (!allocator.blocks_.empty()) {
+		return 0;
+	}
+	_Tp *ptr = allocator.allocate(count);
+	ptr[count - 1] = _Tp(1);
+	allocator.deallocate(ptr, count);
+	
+	return allocator.blocks_.size() == 1;
+}
+
+/// Test for the reuse of the decommitted ranges of a reserved block source
+template<typename _Tp, std::size_t _BlockSize>
+int reserved_source_usage() {
+	
+	using Source = ReservedBlockSource<64 * detail::MiB>;
+	
+	// Freed blocks are decommitted and no longer contained, neighbouring ones
+	// are merged and split again
+	Source source;
+	std::vector<char *> blocks;
+	for (std::size_t i = 0; i < 4; ++i) {
+		blocks.push_back(static_cast<char *>(
+			source.allocate(_BlockSize, _BlockSize)));
+	}
+	source.deallocate(blocks[1], _BlockSize, _BlockSize);
+	source.deallocate(blocks[2], _BlockSize, _BlockSize);
+	if (source.contains(blocks[1]) || source.contains(blocks[2] + 1) ||
+		!source.contains(blocks[0]) || !source.contains(blocks[3])) {
+		return 0;
+	}
+	if (source.allocate(_BlockSize, _BlockSize) != blocks[1] ||
+		source.allocate(_BlockSize, _BlockSize) != blocks[2]) {
+		return 0;
+	}
+	for (auto block : blocks) {
+		source.deallocate(block, _BlockSize, _BlockSize);
+	}
+	if (source.contains(blocks[0]) ||
+		source.allocate(4 * _BlockSize, _BlockSize) != blocks[0]) {
+		return 0;
+	}
+	source.deallocate(blocks[0], 4 * _BlockSize, _BlockSize);
+	
+	// Reserving and trimming segments of any size never runs out of addresses
+	using Allocator = PoolAllocator<_Tp, _BlockSize, false,
+		detail::size_classes(_BlockSize), Source>;
+	Allocator allocator;
+	_Tp *kept = allocator.allocate(1);
+	const std::size_t sizes[] = {700, 100, 500, 300, 750, 200, 600, 400};
+	for (std::size_t round = 0; round < 4; ++round) {
+		for (std::size_t n_blocks : sizes) {
+			allocator.reserve(n_blocks * Allocator::max_count());
+			_Tp *ptr = allocator.allocate(Allocator::max_count());
+			ptr[0] = _Tp(1);
+			allocator.deallocate(ptr, Allocator::max_count());
+			allocator.trim();
+			if (allocator.blocks() != 1 || allocator.owns(ptr) ||
+				!allocator.owns(kept)) {
+				return 0;
+			}
+		}
+	}
+	allocator.deallocate(kept, 1);
+	
+	return 1;
+}
+
+#endif /* test_blockSource_h */
@@ -0,0 +1,91 @@
+//
+//  test_bulk.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_bulk_h
+#define test_bulk_h
+
+#include "test_util.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/// Test for allocating and deallocating many single elements at once
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots>
+int bulk_usage() {
+	
+	using Allocator = PoolAllocator<_Tp, _BlockSize, _Recycle_Slots>;
+	const std::size_t n = 5 * Allocator::max_count() + 7;
+	
+	Allocator allocator;
+	
+	// A few free single slots scattered around
+	std::vector<_Tp *> singles;
+	for (std::size_t i = 0; i < 100; ++i) {
+		singles.push_back(allocator.allocate(1));
+	}
+	for (std::size_t i = 0; i < singles.size(); i += 3) {
+		allocator.deallocate(singles[i], 1);
+	}
+	
+	// Distinct and usable, the free single slots first
+	std::vector<_Tp *> ptrs(n);
+	allocator.allocate_bulk(ptrs.data(), n);
+	std::vector<_Tp *> sorted = ptrs;
+	std::sort(sorted.begin(), sorted.end());
+	if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+		return 0;
+	}
+	for (std::size_t i = 0; i < singles.size(); i += 3) {
+		if (std::find(ptrs.begin(), ptrs.begin() + 34, singles[i]) ==
+			ptrs.begin() + 34) {
+			return 0;
+		}
+	}
+	for (std::size_t i = 0; i < n; ++i) {
+		*ptrs[i] = _Tp(i);
+	}
+	for (std::size_t i = 1; i < singles.size(); ++i) {
+		if (i % 3 != 0 &&
+			std::binary_search(sorted.begin(), sorted.end(), singles[i])) {
+			return 0;
+		}
+	}
+	for (std::size_t i = 0; i < n; ++i) {
+		if (*ptrs[i] != _Tp(i) || !allocator.owns(ptrs[i])) {
+			return 0;
+		}
+	}
+	
+	// The runs in order go back as whole chunks, the rest as single slots
+	std::reverse(ptrs.begin(), ptrs.begin() + n / 2);
+	allocator.deallocate_bulk(ptrs.data(), n);
+	for (std::size_t i = 1; i < singles.size(); ++i) {
+		if (i % 3 != 0) {
+			allocator.deallocate(singles[i], 1);
+		}
+	}
+	allocator.recycle_slots();
+	if (allocator.empty_blocks() != allocator.blocks()) {
+		return 0;
+	}
+	
+	// From another thread, all at once: reused without a new block
+	allocator.set_owner(std::this_thread::get_id());
+	allocator.allocate_bulk(ptrs.data(), n);
+	const std::size_t blocks = allocator.blocks();
+	std::thread([&]() { allocator.deallocate_bulk(ptrs.data(), n); }).join();
+	allocator.allocate_bulk(ptrs.data(), n);
+	if (allocator.blocks() != blocks) {
+		return 0;
+	}
+	allocator.deallocate_bulk(ptrs.data(), n);
+	
+	return 1;
+}
+
+#endif /* test_bulk_h */
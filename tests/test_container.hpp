@@ -19,7 +19,7 @@ template <template <typename... __T> class _Container, typename _Tp,
 int stl_usage() {
 
   std::cout << "Testing Container:\t\t" << std::flush;
-  _Container<_Tp, ALLOCATOR(_Tp, _BlockSize)> my_container;
+  _Container<_Tp, ARENA_ALLOCATOR(_Tp, _BlockSize)> my_container;
 
   const std::size_t min = 0;
   const std::size_t max = 1 << 14;
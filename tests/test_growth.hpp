@@ -0,0 +1,89 @@
+//
+//  test_growth.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_growth_h
+#define test_growth_h
+
+#include "test_util.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// Test for taking blocks from the block source in segments of growing size
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots,
+		 class _Block_Source>
+int growth_usage() {
+	
+	using Allocator =
+		PoolAllocator<_Tp, _BlockSize, _Recycle_Slots,
+					  detail::size_classes(_BlockSize), _Block_Source,
+					  GeometricGrowth<8>>;
+	const std::size_t count = Allocator::max_count();
+	const std::size_t n_blocks = 40;
+	
+	Allocator allocator;
+	
+	// Segments of 1, 1, 2, 4, 8, 8, 8, 8 blocks
+	std::vector<_Tp *> chunks;
+	for (std::size_t i = 0; i < n_blocks; ++i) {
+		chunks.push_back(allocator.allocate(count));
+		chunks.back()[0] = _Tp(i);
+		chunks.back()[count - 1] = _Tp(i);
+	}
+	if (allocator.blocks_.size() != 8 || allocator.blocks() != n_blocks) {
+		return 0;
+	}
+	for (auto block : allocator.blocks_) {
+		if (reinterpret_cast<std::uintptr_t>(block) % _BlockSize != 0) {
+			return 0;
+		}
+	}
+	for (std::size_t i = 0; i < n_blocks; ++i) {
+		if (!allocator.owns(chunks[i]) || !allocator.owns(chunks[i] + count - 1) ||
+			chunks[i][0] != _Tp(i) || chunks[i][count - 1] != _Tp(i)) {
+			return 0;
+		}
+	}
+	
+	// Half the blocks of every segment: the pages are dropped, only the first
+	// segment (of a single block) is given back
+	TrimPolicy policy;
+	policy.spare_blocks = 0;
+	allocator.set_trim_policy(policy);
+	for (std::size_t i = 0; i < n_blocks; i += 2) {
+		allocator.deallocate(chunks[i], count);
+	}
+	if (allocator.blocks_.size() != 7 || allocator.empty_blocks() != 0) {
+		return 0;
+	}
+	
+	// Released blocks are reused before taking more from the source
+	for (std::size_t i = 0; i < n_blocks; i += 2) {
+		chunks[i] = allocator.allocate(count);
+		chunks[i][count - 1] = _Tp(i);
+	}
+	if (allocator.blocks_.size() != 8) {
+		return 0;
+	}
+	
+	// Segments are given back as soon as all of their blocks were released
+	for (auto chunk : chunks) {
+		allocator.deallocate(chunk, count);
+	}
+	if (!allocator.blocks_.empty() || allocator.blocks() != 0) {
+		return 0;
+	}
+	
+	// And the growth starts over
+	_Tp *ptr = allocator.allocate(count);
+	allocator.deallocate(allocator.allocate(1), 1);
+	allocator.deallocate(ptr, count);
+	
+	return allocator.blocks() == 1 || allocator.blocks() == 2;
+}
+
+#endif /* test_growth_h */
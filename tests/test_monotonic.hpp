@@ -0,0 +1,84 @@
+//
+//  test_monotonic.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_monotonic_h
+#define test_monotonic_h
+
+#include "test_util.hpp"
+#include "../monotonicArena.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+/// Test for containers on a bump-pointer arena, reset between rounds
+template<std::size_t _BlockSize, class _Block_Source>
+int monotonic_usage() {
+
+	struct alignas(64) Aligned {
+		char bytes[64];
+	};
+	using IntAllocator = MonotonicAllocator<int, _BlockSize, _Block_Source>;
+	using MapAllocator = typename IntAllocator::template rebind<
+		std::pair<const int, int>>::other;
+	using AlignedAllocator =
+		typename IntAllocator::template rebind<Aligned>::other;
+
+	IntAllocator allocator;
+	const auto arena = allocator.arena();
+	std::size_t blocks = 0;
+	int *first = nullptr;
+
+	for (int round = 0; round < 3; ++round) {
+		{
+			std::list<int, IntAllocator> list(allocator);
+			std::map<int, int, std::less<int>, MapAllocator> map(allocator);
+			std::vector<Aligned, AlignedAllocator> aligned(allocator);
+			for (int i = 0; i < 10000; ++i) {
+				list.push_back(i);
+				map.emplace(i, i);
+				aligned.emplace_back();
+			}
+			if (reinterpret_cast<std::uintptr_t>(aligned.data()) % 64 != 0) {
+				return 0;
+			}
+
+			// Larger than a block
+			std::vector<char, typename IntAllocator::template rebind<
+				char>::other> large(4 * _BlockSize, 'a', allocator);
+			large.back() = 'b';
+
+			int expected = 0;
+			for (int i : list) {
+				if (i != expected || map[expected] != expected) {
+					return 0;
+				}
+				++expected;
+			}
+		}
+
+		// Every round fills the same blocks from the start
+		int *ptr = allocator.allocate(1);
+		if (round == 0) {
+			first = ptr;
+			blocks = arena->blocks();
+		} else if (ptr != first || arena->blocks() != blocks) {
+			return 0;
+		}
+		arena->reset();
+		if (arena->blocks_in_use() != 0) {
+			return 0;
+		}
+	}
+
+	arena->release();
+	return arena->blocks() == 0;
+}
+
+#endif /* test_monotonic_h */
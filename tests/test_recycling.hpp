@@ -10,53 +10,62 @@
 
 #include "test_util.hpp"
 
-#include <list>
+#include <vector>
 
-/// Test for the recycling algorithm;
-template<typename _Tp, std::size_t _BlockSize>
+/// Test for the recycling algorithm: chunks freed next to each other merge
+/// back right away when recycling slots, and on recycle_slots() otherwise.
+/// Once merged back, the block is empty and leaves the free chunks
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots>
 int recycle_alg() {
 	
-	// for dummy valid pointer address
-	_Tp a = 0.;
-	
 	std::size_t size = 10;
 	std::size_t count = 3;
-	std::size_t offset = 2;
 	
-	PoolAllocator<_Tp, _BlockSize> allocator;
+	PoolAllocator<_Tp, _BlockSize, _Recycle_Slots> allocator;
 	
-	// Fill list
+	// Consecutive chunks, all carved from the same block
+	std::vector<_Tp *> chunks;
 	for (std::size_t i = 0; i < size; ++i) {
-		allocator.deallocate(&((&a)[i * (count+offset)]), count);
+		chunks.push_back(allocator.allocate(count));
+	}
+	if (allocator.blocks_.size() != 1) {
+		return 0;
+	}
+	
+	// Every other chunk: none of them has a free neighbour
+	for (std::size_t i = 0; i < size; i += 2) {
+		allocator.deallocate(chunks[i], count);
+	}
+	if (allocator.free_chunks() != size / 2 + 1) {
+		return 0;
+	}
+	
+	// Fill the holes
+	for (std::size_t i = 1; i < size; i += 2) {
+		allocator.deallocate(chunks[i], count);
+	}
+	if (_Recycle_Slots && allocator.empty_blocks() != 1) {
+		return 0;
 	}
 	
 	// Test algorithm!
 	allocator.recycle_slots();
-	
-	if (offset == 0 && allocator.chunks_.size() == 1) {
-		return 1;
+	if (allocator.free_chunks() != 0 || allocator.empty_blocks() != 1) {
+		return 0;
 	}
 	
-	else if (offset != 0)
-	{
-		auto current = allocator.chunks_.begin();
-		auto next = current;
-		++next;
-		while(next != allocator.chunks_.end()) {
-			if(static_cast<ptrdiff_t>(next->ptr - current->ptr) != offset+count)
-			{
-				return 0;
-			}
-			++current;
-			++next;
-		}
-		
-		return 1;
+	// Single slots are folded back as well
+	std::vector<_Tp *> slots;
+	for (std::size_t i = 0; i < size; ++i) {
+		slots.push_back(allocator.allocate(1));
+	}
+	for (auto slot : slots) {
+		allocator.deallocate(slot, 1);
 	}
+	allocator.recycle_slots();
 	
-	return 0;
+	return allocator.free_chunks() == 0 && allocator.empty_blocks() == 1 &&
+		allocator.slots_ == nullptr;
 }
 
 #endif /* test_recycling_h */
-
-
@@ -0,0 +1,94 @@
+//
+//  test_reserve.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_reserve_h
+#define test_reserve_h
+
+#include "test_util.hpp"
+
+#include <vector>
+
+/// Test for reserving (and faulting in) the blocks of a pool up front
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots,
+		 class _Block_Source>
+int reserve_usage() {
+	
+	using Allocator =
+		PoolAllocator<_Tp, _BlockSize, _Recycle_Slots,
+					  detail::size_classes(_BlockSize), _Block_Source>;
+	const std::size_t count = Allocator::max_count();
+	const std::size_t n_slots = 5 * count / 2;
+	
+	Allocator allocator;
+	
+	// All the blocks at once, in address order
+	if (allocator.reserve(n_slots) != 3 || allocator.blocks_.size() != 1 ||
+		allocator.blocks() != 3 || allocator.reserve(n_slots) != 0) {
+		return 0;
+	}
+	allocator.prefault();
+	
+	// Any mix of allocations up to the reserved size takes no new block
+	std::vector<_Tp *> slots, chunks;
+	for (std::size_t i = 0; i < n_slots / 2; ++i) {
+		slots.push_back(allocator.allocate(1));
+		*slots.back() = _Tp(i);
+	}
+	for (std::size_t i = 0; i < n_slots / 2 / 64; ++i) {
+		chunks.push_back(allocator.allocate(64));
+		chunks.back()[63] = _Tp(i);
+	}
+	if (allocator.blocks() != 3) {
+		return 0;
+	}
+	
+	// Faulting in the free memory leaves the allocations alone
+	allocator.prefault();
+	for (std::size_t i = 0; i < slots.size(); ++i) {
+		if (*slots[i] != _Tp(i)) {
+			return 0;
+		}
+	}
+	for (std::size_t i = 0; i < chunks.size(); ++i) {
+		if (chunks[i][63] != _Tp(i)) {
+			return 0;
+		}
+		allocator.deallocate(chunks[i], 64);
+	}
+	for (auto slot : slots) {
+		allocator.deallocate(slot, 1);
+	}
+	
+	// Released blocks are brought back first
+	TrimPolicy policy;
+	policy.release = BlockRelease::DontNeed;
+	allocator.set_trim_policy(policy);
+	allocator.trim();
+	if (allocator.blocks() != 3 || allocator.empty_blocks() != 0 ||
+		allocator.reserve(n_slots) != 0) {
+		return 0;
+	}
+	allocator.prefault();
+	_Tp *ptr = allocator.allocate(count);
+	ptr[count - 1] = _Tp(1);
+	allocator.deallocate(ptr, count);
+	if (allocator.blocks() != 3) {
+		return 0;
+	}
+	
+	// Nothing to reserve for elements larger than a block
+	struct Huge {
+		char bytes[2 * _BlockSize];
+	};
+	PoolAllocator<Huge, _BlockSize, _Recycle_Slots,
+				  detail::size_classes(_BlockSize), _Block_Source>
+		huge_allocator;
+	return huge_allocator.reserve(n_slots) == 0 &&
+		   huge_allocator.blocks() == 0;
+}
+
+#endif /* test_reserve_h */
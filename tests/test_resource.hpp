@@ -0,0 +1,88 @@
+//
+//  test_resource.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_resource_h
+#define test_resource_h
+
+#include "test_util.hpp"
+#include "../poolResource.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+/// Test for std::pmr containers on top of a PoolResource
+template<std::size_t _BlockSize, bool _Recycle_Slots>
+int resource_usage() {
+
+	PoolResource<_BlockSize, _Recycle_Slots> resource;
+
+	// Any size and alignment, each allocation filled with its own byte
+	const std::size_t sizes[] = {0, 1, 7, 8, 9, 24, 64, 65, 200, 5000,
+		_BlockSize, 4 * _BlockSize};
+	const std::size_t alignments[] = {1, 8, 16, 64, 4096};
+	struct Allocation {
+		unsigned char *ptr;
+		std::size_t size, alignment;
+	};
+	std::vector<Allocation> allocations;
+	for (std::size_t round = 0; round < 3; ++round) {
+		for (std::size_t size : sizes) {
+			for (std::size_t alignment : alignments) {
+				auto ptr = static_cast<unsigned char *>(
+					resource.allocate(size, alignment));
+				if (reinterpret_cast<std::uintptr_t>(ptr) % alignment != 0) {
+					return 0;
+				}
+				std::memset(ptr, static_cast<int>(allocations.size()), size);
+				allocations.push_back(Allocation{ptr, size, alignment});
+			}
+		}
+	}
+	for (std::size_t i = 0; i < allocations.size(); ++i) {
+		const Allocation &allocation = allocations[i];
+		for (std::size_t j = 0; j < allocation.size; ++j) {
+			if (allocation.ptr[j] != static_cast<unsigned char>(i)) {
+				return 0;
+			}
+		}
+		resource.deallocate(allocation.ptr, allocation.size,
+							allocation.alignment);
+	}
+
+	// Every block goes back once everything was freed
+	resource.trim();
+	if (resource.large_pool().blocks() != 0 ||
+		resource.template pool<0>().blocks() != 0) {
+		return 0;
+	}
+
+	// Containers, directly or behind a std::pmr pool
+	std::pmr::unsynchronized_pool_resource pools(&resource);
+	std::pmr::vector<int> vector(&resource);
+	std::pmr::list<double> list(&resource);
+	std::pmr::map<int, int> map(&pools);
+	for (int i = 0; i < 10000; ++i) {
+		vector.push_back(i);
+		list.push_back(i);
+		map.emplace(i, i);
+	}
+	int expected = 0;
+	for (double value : list) {
+		if (value != vector[expected] || map[expected] != expected) {
+			return 0;
+		}
+		++expected;
+	}
+
+	std::pmr::unsynchronized_pool_resource other;
+	return resource.is_equal(resource) && !resource.is_equal(other);
+}
+
+#endif /* test_resource_h */
@@ -0,0 +1,137 @@
+//
+//  test_slab.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_slab_h
+#define test_slab_h
+
+#include "test_util.hpp"
+#include "../slabAllocator.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+/// Test for the bitmap slab allocator
+template<typename _Tp, std::size_t _BlockSize, class _Block_Source>
+int slab_usage() {
+
+	using Allocator = SlabAllocator<_Tp, _BlockSize, _Block_Source>;
+	const std::size_t slots = Allocator::slots_in_block();
+	Allocator allocator;
+
+	// A block holds slots_in_block() single elements, the next one takes
+	// another block
+	std::vector<_Tp *> singles;
+	for (std::size_t i = 0; i < slots; ++i) {
+		singles.push_back(allocator.allocate(1));
+		*singles.back() = _Tp(i);
+	}
+	if (allocator.blocks() != 1 || allocator.free_slots() != 0 ||
+		allocator.slots_in_use() != slots) {
+		return 0;
+	}
+	_Tp *extra = allocator.allocate(1);
+	if (allocator.blocks() != 2) {
+		return 0;
+	}
+	allocator.deallocate(extra, 1);
+
+	// Freed singles merge by themselves: a whole block fits in their place
+	for (std::size_t i = 0; i < slots; ++i) {
+		if (*singles[i] != _Tp(i)) {
+			return 0;
+		}
+		allocator.deallocate(singles[i], 1);
+	}
+	_Tp *whole = allocator.allocate(Allocator::max_count());
+	_Tp *other = allocator.allocate(Allocator::max_count());
+	if (allocator.blocks() != 2 || allocator.slots_in_use() != 2 * slots) {
+		return 0;
+	}
+	allocator.deallocate(whole, Allocator::max_count());
+	allocator.deallocate(other, Allocator::max_count());
+
+	// Runs of random lengths, freed in random order, never overlap
+	struct Run {
+		_Tp *ptr;
+		std::size_t count;
+	};
+	std::mt19937 generator{};
+	std::vector<Run> runs;
+	std::size_t in_use = 0;
+	for (std::size_t i = 0; i < 20000; ++i) {
+		if (!runs.empty() && generator() % 2 == 0) {
+			std::swap(runs[generator() % runs.size()], runs.back());
+			const Run run = runs.back();
+			runs.pop_back();
+			for (std::size_t j = 0; j < run.count; ++j) {
+				if (run.ptr[j] != _Tp(run.count + j)) {
+					return 0;
+				}
+			}
+			allocator.deallocate(run.ptr, run.count);
+			in_use -= run.count;
+			continue;
+		}
+		const std::size_t count = 1 + generator() % 150;
+		Run run{allocator.allocate(count), count};
+		for (std::size_t j = 0; j < count; ++j) {
+			run.ptr[j] = _Tp(count + j);
+		}
+		runs.push_back(run);
+		in_use += count;
+	}
+	if (allocator.slots_in_use() != in_use ||
+		allocator.free_slots() + in_use != allocator.blocks() * slots) {
+		return 0;
+	}
+	for (const Run &run : runs) {
+		allocator.deallocate(run.ptr, run.count);
+	}
+
+	// Empty slabs go back to the source on trim
+	const std::size_t held = allocator.blocks();
+	if (allocator.trim(1) != held - 1 || allocator.blocks() != 1 ||
+		allocator.trim() != 1 || allocator.blocks() != 0) {
+		return 0;
+	}
+
+	// Each allocator frees its own elements only
+	static_assert(!std::allocator_traits<Allocator>::is_always_equal::value,
+				  "A slab allocator owns its slabs");
+	Allocator another;
+	if (!(allocator == allocator) || allocator == another ||
+		!(allocator != another)) {
+		return 0;
+	}
+
+	// Larger than a block
+	const std::size_t large = 3 * Allocator::max_count();
+	_Tp *ptr = allocator.allocate(large);
+	ptr[large - 1] = _Tp(1);
+	allocator.deallocate(ptr, large);
+
+	// Over-aligned elements
+	struct alignas(64) Line {
+		char bytes[64];
+	};
+	typename Allocator::template rebind<Line>::other lines;
+	std::vector<Line *> aligned;
+	for (std::size_t i = 0; i < 100; ++i) {
+		aligned.push_back(lines.allocate(1 + i % 3));
+		if (reinterpret_cast<std::uintptr_t>(aligned.back()) % 64 != 0) {
+			return 0;
+		}
+	}
+	for (std::size_t i = 0; i < aligned.size(); ++i) {
+		lines.deallocate(aligned[i], 1 + i % 3);
+	}
+	return 1;
+}
+
+#endif /* test_slab_h */
@@ -0,0 +1,95 @@
+//
+//  test_stats.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_stats_h
+#define test_stats_h
+
+#include "test_util.hpp"
+
+#include <vector>
+
+/// Test for the counters and the free memory of the pool statistics
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots>
+int stats_usage() {
+	
+	using Allocator = PoolAllocator<_Tp, _BlockSize, _Recycle_Slots>;
+	const std::size_t count = Allocator::max_count();
+	
+	Allocator allocator;
+	
+	// A fresh pool has nothing
+	PoolStats stats = allocator.stats();
+	if (stats.bytes_reserved != 0 || stats.bytes_free != 0 ||
+		stats.fragmentation != 0.) {
+		return 0;
+	}
+	
+	// Two whole blocks, a large allocation and single slots
+	std::vector<_Tp *> chunks, slots;
+	chunks.push_back(allocator.allocate(count));
+	chunks.push_back(allocator.allocate(count));
+	_Tp *large = allocator.allocate(2 * count);
+	for (std::size_t i = 0; i < 100; ++i) {
+		slots.push_back(allocator.allocate(1));
+	}
+	stats = allocator.stats();
+	if (stats.bytes_reserved < 3 * _BlockSize || stats.free_chunks != 1) {
+		return 0;
+	}
+	
+	// Every other slot freed: free memory is scattered
+	for (std::size_t i = 0; i < slots.size(); i += 2) {
+		allocator.deallocate(slots[i], 1);
+	}
+	stats = allocator.stats();
+	if (stats.bytes_free == 0 || stats.fragmentation <= 0.) {
+		return 0;
+	}
+	
+	// A whole empty block is all the free memory but the rest
+	allocator.deallocate(chunks.back(), count);
+	chunks.pop_back();
+	stats = allocator.stats();
+	if (stats.fragmentation <= 0. || stats.fragmentation >= 0.5) {
+		return 0;
+	}
+	
+#ifdef POOL_STATS_ENABLED
+	// The large allocation is only known to the counters
+	if (stats.bytes_reserved < 3 * _BlockSize + 2 * count * sizeof(_Tp)) {
+		return 0;
+	}
+	if (stats.allocations != 103 || stats.frees != 51 ||
+		stats.bytes_in_use != (count + 2 * count + 50) * sizeof(_Tp) ||
+		stats.blocks_allocated != 3 || stats.blocks_freed != 0) {
+		return 0;
+	}
+	
+	allocator.trim();
+	stats = allocator.stats();
+	if (stats.recycles != 1 || stats.blocks_freed != 1) {
+		return 0;
+	}
+#endif
+	
+	allocator.deallocate(large, 2 * count);
+	allocator.deallocate(chunks.back(), count);
+	for (std::size_t i = 1; i < slots.size(); i += 2) {
+		allocator.deallocate(slots[i], 1);
+	}
+	
+#ifdef POOL_STATS_ENABLED
+	stats = allocator.stats();
+	if (stats.bytes_in_use != 0 || stats.allocations != stats.frees) {
+		return 0;
+	}
+#endif
+	
+	return 1;
+}
+
+#endif /* test_stats_h */
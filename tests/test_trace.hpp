@@ -0,0 +1,76 @@
+//
+//  test_trace.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_trace_h
+#define test_trace_h
+
+#include "test_util.hpp"
+
+#include <cstdio>
+#include <vector>
+
+/// Test for recording an allocation trace and reading it back
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots>
+int trace_usage() {
+	
+	using Allocator = PoolAllocator<_Tp, _BlockSize, _Recycle_Slots>;
+	const char *path = "test_trace.bin";
+	
+	Allocator allocator;
+	
+	// Not recorded
+	_Tp *before = allocator.allocate(3);
+	
+	if (!allocator.start_trace(path)) {
+		return 0;
+	}
+	std::vector<_Tp *> ptrs;
+	for (std::size_t i = 1; i <= 10000; ++i) {
+		ptrs.push_back(allocator.allocate(i % 7 + 1));
+	}
+	allocator.deallocate(before, 3);
+	for (std::size_t i = 1; i <= ptrs.size(); ++i) {
+		allocator.deallocate(ptrs[i - 1], i % 7 + 1);
+	}
+	allocator.stop_trace();
+	
+	// Not recorded either
+	allocator.deallocate(allocator.allocate(1), 1);
+	
+	TraceHeader header;
+	std::vector<TraceRecord> records;
+	if (!read_trace(path, header, records)) {
+		return 0;
+	}
+	std::remove(path);
+	
+	if (header.element_size != sizeof(_Tp) || header.block_size != _BlockSize ||
+		header.recycle_slots != _Recycle_Slots || records.size() != 20001) {
+		return 0;
+	}
+	for (std::size_t i = 0; i < records.size(); ++i) {
+		const TraceRecord &record = records[i];
+		const bool allocate = i < ptrs.size();
+		if ((record.op == TraceOp::Allocate) != allocate ||
+			(i > 0 && record.time < records[i - 1].time)) {
+			return 0;
+		}
+		if (allocate &&
+			(record.object != reinterpret_cast<std::uintptr_t>(ptrs[i]) ||
+			 record.count != (i + 1) % 7 + 1)) {
+			return 0;
+		}
+	}
+	if (records[ptrs.size()].object !=
+		reinterpret_cast<std::uintptr_t>(before)) {
+		return 0;
+	}
+	
+	return 1;
+}
+
+#endif /* test_trace_h */
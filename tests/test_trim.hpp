@@ -0,0 +1,164 @@
+//
+//  test_trim.hpp
+//  memorypool
+//
+//  Created by Francisco Meirinhos on 16/10/2017.
+//
+
+#ifndef test_trim_h
+#define test_trim_h
+
+#include "test_util.hpp"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// Test for giving the empty blocks back to the system
+template<typename _Tp, std::size_t _BlockSize, bool _Recycle_Slots>
+int trim_usage() {
+	
+	using Allocator = PoolAllocator<_Tp, _BlockSize, _Recycle_Slots>;
+	const std::size_t count = Allocator::max_count();
+	const std::size_t n_blocks = 4;
+	
+	Allocator allocator;
+	
+	// A burst of whole blocks and of single slots
+	std::vector<_Tp *> chunks, slots;
+	for (std::size_t i = 0; i < n_blocks; ++i) {
+		chunks.push_back(allocator.allocate(count));
+	}
+	for (std::size_t i = 0; i < n_blocks * count; ++i) {
+		slots.push_back(allocator.allocate(1));
+	}
+	for (auto chunk : chunks) {
+		allocator.deallocate(chunk, count);
+	}
+	for (auto slot : slots) {
+		allocator.deallocate(slot, 1);
+	}
+	
+	// Empty blocks are kept for reuse by default
+	if (allocator.empty_blocks() != n_blocks) {
+		return 0;
+	}
+	
+	// The blocks of the single slots are only empty once folded back
+	allocator.trim(1);
+	if (allocator.blocks_.size() != 1 || allocator.empty_blocks() != 1) {
+		return 0;
+	}
+	
+	// No spare blocks: released as soon as empty
+	TrimPolicy policy;
+	policy.spare_blocks = 0;
+	allocator.set_trim_policy(policy);
+	if (!allocator.blocks_.empty()) {
+		return 0;
+	}
+	chunks.clear();
+	for (std::size_t i = 0; i < n_blocks; ++i) {
+		chunks.push_back(allocator.allocate(count));
+	}
+	for (auto chunk : chunks) {
+		allocator.deallocate(chunk, count);
+	}
+	if (!allocator.blocks_.empty()) {
+		return 0;
+	}
+	
+	// The pages are dropped but the blocks are kept, and reused first
+	policy.release = BlockRelease::DontNeed;
+	allocator.set_trim_policy(policy);
+	for (int round = 0; round < 2; ++round) {
+		chunks.clear();
+		for (std::size_t i = 0; i < n_blocks; ++i) {
+			chunks.push_back(allocator.allocate(count));
+			chunks.back()[count - 1] = _Tp();
+		}
+		for (auto chunk : chunks) {
+			allocator.deallocate(chunk, count);
+		}
+		if (allocator.blocks_.size() != n_blocks ||
+			allocator.empty_blocks() != 0) {
+			return 0;
+		}
+	}
+	
+	// Back to deleting: the blocks released meanwhile are given back as well
+	policy.release = BlockRelease::Delete;
+	allocator.set_trim_policy(policy);
+	if (allocator.blocks() != 0) {
+		return 0;
+	}
+	
+	// So are the segments of several blocks, once all of them were released
+	policy.release = BlockRelease::DontNeed;
+	allocator.set_trim_policy(policy);
+	allocator.reserve(n_blocks * count);
+	chunks.clear();
+	for (std::size_t i = 0; i < n_blocks; ++i) {
+		chunks.push_back(allocator.allocate(count));
+	}
+	for (auto chunk : chunks) {
+		allocator.deallocate(chunk, count);
+	}
+	if (allocator.blocks_.size() != 1 || allocator.blocks() != n_blocks) {
+		return 0;
+	}
+	policy.release = BlockRelease::Delete;
+	allocator.set_trim_policy(policy);
+	if (allocator.blocks() != 0) {
+		return 0;
+	}
+	
+	// Single slots and chunks of any size, freed in random order, leave no
+	// slot behind: every block can be given back
+	Allocator scattered;
+	std::mt19937 generator{};
+	std::vector<std::pair<_Tp *, std::size_t>> ptrs;
+	for (std::size_t i = 0; i < 20000; ++i) {
+		const std::size_t n = generator() % 4 == 0 ? 1 + generator() % 9 : 1;
+		ptrs.emplace_back(scattered.allocate(n), n);
+		if (generator() % 3 == 0) {
+			std::swap(ptrs[generator() % ptrs.size()], ptrs.back());
+			scattered.deallocate(ptrs.back().first, ptrs.back().second);
+			ptrs.pop_back();
+		}
+	}
+	for (const auto &ptr : ptrs) {
+		scattered.deallocate(ptr.first, ptr.second);
+	}
+	const std::size_t held = scattered.blocks();
+	if (scattered.trim() != held || scattered.blocks() != 0) {
+		return 0;
+	}
+	
+	// With an idle time, trim only gives back the blocks empty for that long
+	Allocator idle;
+	TrimPolicy idle_policy;
+	idle_policy.idle_time = std::chrono::milliseconds(20);
+	idle.set_trim_policy(idle_policy);
+	slots.clear();
+	for (std::size_t i = 0; i < n_blocks * count; ++i) {
+		slots.push_back(idle.allocate(1));
+	}
+	for (auto slot : slots) {
+		idle.deallocate(slot, 1);
+	}
+	const std::size_t idle_held = idle.blocks();
+	if (idle.trim() != 0 || idle.empty_blocks() != idle_held) {
+		return 0;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	if (idle.trim() != idle_held || idle.blocks() != 0) {
+		return 0;
+	}
+	
+	return 1;
+}
+
+#endif /* test_trim_h */
@@ -9,15 +9,42 @@
 #define test_util_h
 
 #include "../poolAllocator.hpp"
-#include "../listAllocator.hpp"
+#include "../poolArena.hpp"
 //#include "../threadSafeQueue.hpp"
 
 #ifdef USE_STD_ALLOCATOR
 #define ALLOCATOR(_T, BLOCK_SIZE) std::allocator<_T>
+#define ARENA_ALLOCATOR(_T, BLOCK_SIZE) std::allocator<_T>
 #else
 #define ALLOCATOR(_T, BLOCK_SIZE) _fmmAllocator::PoolAllocator<_T, BLOCK_SIZE>
+#define ARENA_ALLOCATOR(_T, BLOCK_SIZE)                                        \
+  _fmmAllocator::ArenaAllocator<_T, BLOCK_SIZE>
 #endif
 
 using namespace _fmmAllocator;
 
+/// An element of _N doubles: the slots it takes are not a divisor of the
+/// padding of a chunk for _N = 2 (16 bytes) or 3 (24 bytes)
+template<std::size_t _N>
+struct Doubles {
+	Doubles() = default;
+	explicit Doubles(std::size_t i) {
+		for (std::size_t k = 0; k < _N; ++k) {
+			values[k] = static_cast<double>(i + k);
+		}
+	}
+
+	bool operator==(const Doubles &other) const {
+		for (std::size_t k = 0; k < _N; ++k) {
+			if (values[k] != other.values[k]) {
+				return false;
+			}
+		}
+		return true;
+	}
+	bool operator!=(const Doubles &other) const { return !(*this == other); }
+
+	double values[_N] = {};
+};
+
 #endif /* test_util_h */
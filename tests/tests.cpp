@@ -10,10 +10,24 @@
 
 // Always test with the assert enabled!
 #define DEQUE_ASSERT_ENABLED
+#define POOL_STATS_ENABLED
+#define POOL_TRACE_ENABLED
 
+#include "test_alignment.hpp"
 #include "test_allocator.hpp"
+#include "test_arena.hpp"
+#include "test_blockSource.hpp"
+#include "test_bulk.hpp"
 #include "test_container.hpp"
+#include "test_growth.hpp"
+#include "test_monotonic.hpp"
 #include "test_recycling.hpp"
+#include "test_reserve.hpp"
+#include "test_resource.hpp"
+#include "test_slab.hpp"
+#include "test_stats.hpp"
+#include "test_trace.hpp"
+#include "test_trim.hpp"
 
 #include <deque>
 #include <stdio.h>
@@ -26,6 +40,81 @@ int main() {
 
   /// Test pool allocator
   assert(static_cast<bool>(pool_usage<ScalarType, BlockSize>()));
+  assert(static_cast<bool>(slot_usage<ScalarType, BlockSize>()));
+  assert(static_cast<bool>(large_usage<BlockSize>()));
+
+  /// Test the bulk allocations
+  assert(static_cast<bool>(bulk_usage<ScalarType, BlockSize, true>()));
+  assert(static_cast<bool>(bulk_usage<ScalarType, BlockSize, false>()));
+  assert(static_cast<bool>(bulk_usage<Doubles<2>, BlockSize, true>()));
+  assert(static_cast<bool>(bulk_usage<Doubles<3>, BlockSize, false>()));
+
+  /// Test node-based containers sharing an arena
+  assert(static_cast<bool>(arena_usage<BlockSize, true>()));
+  assert(static_cast<bool>(arena_usage<BlockSize, false>()));
+
+  /// Test std::pmr containers on top of the pools
+  assert(static_cast<bool>(resource_usage<BlockSize, true>()));
+  assert(static_cast<bool>(resource_usage<BlockSize, false>()));
+
+  /// Test containers on a bump-pointer arena
+  assert(static_cast<bool>(monotonic_usage<BlockSize, HeapBlockSource>()));
+  assert(
+      static_cast<bool>(monotonic_usage<BlockSize, MmapBlockSource<>>()));
+
+  /// Test the merging of free chunks
+  assert(static_cast<bool>(recycle_alg<ScalarType, BlockSize, true>()));
+  assert(static_cast<bool>(recycle_alg<ScalarType, BlockSize, false>()));
+
+  /// Test giving the empty blocks back
+  assert(static_cast<bool>(trim_usage<ScalarType, BlockSize, true>()));
+  assert(static_cast<bool>(trim_usage<ScalarType, BlockSize, false>()));
+  assert(static_cast<bool>(trim_usage<Doubles<2>, BlockSize, true>()));
+  assert(static_cast<bool>(trim_usage<Doubles<3>, BlockSize, false>()));
+
+  /// Test the pool statistics
+  assert(static_cast<bool>(stats_usage<ScalarType, BlockSize, true>()));
+  assert(static_cast<bool>(stats_usage<ScalarType, BlockSize, false>()));
+  assert(static_cast<bool>(stats_usage<Doubles<2>, BlockSize, true>()));
+  assert(static_cast<bool>(stats_usage<Doubles<3>, BlockSize, false>()));
+
+  /// Test the allocation traces
+  assert(static_cast<bool>(trace_usage<ScalarType, BlockSize, true>()));
+
+  /// Test pools on top of the block sources
+  assert(static_cast<bool>(
+      block_source_usage<ScalarType, BlockSize, HeapBlockSource>()));
+  assert(static_cast<bool>(
+      block_source_usage<ScalarType, BlockSize, MmapBlockSource<>>()));
+  assert(static_cast<bool>(
+      block_source_usage<ScalarType, BlockSize,
+                         ReservedBlockSource<64 * detail::MiB>>()));
+  assert(static_cast<bool>(reserved_source_usage<ScalarType, BlockSize>()));
+
+  /// Test pools growing in segments of blocks
+  assert(static_cast<bool>(
+      growth_usage<ScalarType, BlockSize, true, HeapBlockSource>()));
+  assert(static_cast<bool>(
+      growth_usage<ScalarType, BlockSize, false, MmapBlockSource<>>()));
+  assert(static_cast<bool>(
+      growth_usage<ScalarType, BlockSize, true,
+                   ReservedBlockSource<64 * detail::MiB>>()));
+
+  /// Test reserving blocks up front
+  assert(static_cast<bool>(
+      reserve_usage<ScalarType, BlockSize, true, HeapBlockSource>()));
+  assert(static_cast<bool>(
+      reserve_usage<ScalarType, BlockSize, false, MmapBlockSource<>>()));
+
+  /// Test over-aligned types and slots padded to cache lines
+  assert(static_cast<bool>(alignment_usage<BlockSize, true>()));
+  assert(static_cast<bool>(alignment_usage<BlockSize, false>()));
+
+  /// Test the bitmap slab allocator
+  assert(static_cast<bool>(
+      slab_usage<ScalarType, BlockSize, HeapBlockSource>()));
+  assert(static_cast<bool>(
+      slab_usage<ScalarType, BlockSize, MmapBlockSource<>>()));
 
   /// Test STL containers using allocator
   assert(static_cast<bool>(stl_usage<std::deque, ScalarType, BlockSize>()));
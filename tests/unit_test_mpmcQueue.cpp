@@ -0,0 +1,65 @@
+//
+//  unit_test_mpmcQueue.cpp
+//  memorypool
+//
+
+#include "../mpmcQueue.hpp"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+int main() {
+  MPMCQueue<std::size_t> queue(100);
+  assert(queue.capacity() == 128);
+
+  // Bounded: pushes fail once the ring is full, pops once it is empty
+  for (std::size_t i = 0; i < queue.capacity(); ++i) {
+    assert(queue.try_push(i));
+  }
+  assert(!queue.try_push(0));
+  std::size_t value;
+  for (std::size_t i = 0; i < queue.capacity(); ++i) {
+    assert(queue.try_pop(value) && value == i);
+  }
+  assert(!queue.try_pop(value));
+
+  // Blocking pops need no default constructible element
+  struct Ticket {
+    explicit Ticket(std::size_t number) : number_(number) {}
+    std::size_t number_;
+  };
+  MPMCQueue<Ticket> tickets(4);
+  tickets.push(7);
+  assert(tickets.pop().number_ == 7);
+
+  // Every pushed element is popped exactly once
+  const std::size_t n_threads = 4;
+  const std::size_t n_items = 1 << 14;
+  std::vector<std::size_t> sums(n_threads, 0);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < n_threads; ++i) {
+    threads.emplace_back([&]() {
+      for (std::size_t j = 1; j <= n_items; ++j) {
+        queue.push(j);
+      }
+    });
+    threads.emplace_back([&, i]() {
+      for (std::size_t j = 0; j < n_items; ++j) {
+        sums[i] += queue.pop();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::size_t sum = 0;
+  for (auto partial : sums) {
+    sum += partial;
+  }
+  assert(sum == n_threads * n_items * (n_items + 1) / 2);
+  assert(queue.empty());
+
+  return 0;
+}
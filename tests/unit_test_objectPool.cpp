@@ -0,0 +1,115 @@
+//
+//  unit_test_objectPool.cpp
+//  memorypool
+//
+
+#include "../objectPool.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace _fmmAllocator;
+
+std::atomic<int> constructed{0};
+std::atomic<int> destroyed{0};
+
+struct Object {
+  explicit Object(int __value = 0) : value(__value) { ++constructed; }
+  ~Object() { ++destroyed; }
+
+  int value;
+};
+
+int main() {
+  {
+    ObjectPool<Object, 4 * detail::KiB, 8> pool(4, 7);
+    assert(pool.created() == 4 && constructed == 4);
+
+    // Objects come back as they were given back, and are reused first
+    auto object = pool.acquire();
+    assert(object->value == 7);
+    object->value = 1;
+    Object *const raw = object.get();
+    object.reset();
+    object = pool.acquire();
+    assert(object.get() == raw && object->value == 1);
+    assert(pool.created() == 4);
+
+    // The deleter is a single pointer
+    static_assert(sizeof(object) == 2 * sizeof(void *), "");
+
+    // Objects acquired by one thread and released by others end up in the
+    // others' magazines (and from there back in the pool)
+    std::vector<ObjectPool<Object, 4 * detail::KiB, 8>::handle> objects;
+    std::thread producer([&]() {
+      for (int i = 0; i < 1 << 10; ++i) {
+        objects.push_back(pool.acquire(i));
+      }
+    });
+    producer.join();
+    const std::size_t created = pool.created();
+
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < 4; ++i) {
+      consumers.emplace_back([&, i]() {
+        for (std::size_t j = i; j < objects.size(); j += 4) {
+          objects[j].reset();
+        }
+        for (int round = 0; round < 64; ++round) {
+          auto a = pool.acquire(-1), b = pool.acquire(-1);
+          assert(a.get() != b.get());
+        }
+      });
+    }
+    for (auto &consumer : consumers) {
+      consumer.join();
+    }
+    assert(pool.created() == created);
+    assert(destroyed == 0);
+  }
+
+  // Every object is destroyed once, with the pool
+  assert(constructed == destroyed);
+
+  // An object may outlive its pool
+  {
+    ObjectPool<Object, 4 * detail::KiB, 8>::handle object;
+    {
+      ObjectPool<Object, 4 * detail::KiB, 8> pool;
+      object = pool.acquire(3);
+    }
+    assert(object->value == 3 && destroyed + 1 == constructed);
+  }
+  assert(constructed == destroyed);
+
+  // The objects cached by a thread still running go away with the pool
+  using Pool = ObjectPool<Object, 4 * detail::KiB, 8>;
+  std::mutex mutex;
+  std::condition_variable cv;
+  int stage = 0;
+  std::unique_ptr<Pool> pool(new Pool());
+  std::thread worker([&]() {
+    auto a = pool->acquire(), b = pool->acquire();
+    a.reset();
+    b.reset();
+    std::unique_lock<std::mutex> lock{mutex};
+    stage = 1;
+    cv.notify_all();
+    cv.wait(lock, [&]() { return stage == 2; });
+  });
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    cv.wait(lock, [&]() { return stage == 1; });
+    pool.reset();
+    assert(constructed == destroyed);
+    stage = 2;
+    cv.notify_all();
+  }
+  worker.join();
+  return 0;
+}
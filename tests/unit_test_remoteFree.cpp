@@ -0,0 +1,81 @@
+//
+//  unit_test_remoteFree.cpp
+//  memorypool
+//
+
+#include "../poolAllocator.hpp"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+using namespace _fmmAllocator;
+
+int main() {
+  PoolAllocator<double, 4 * detail::KiB> allocator;
+  allocator.set_owner(std::this_thread::get_id());
+
+  // The owner allocates, other threads free, the owner reuses
+  for (std::size_t round = 0; round < 16; ++round) {
+    std::vector<double *> slots(1 << 10);
+    std::vector<double *> chunks(1 << 6);
+    for (auto &ptr : slots) {
+      ptr = allocator.allocate(1);
+    }
+    for (auto &ptr : chunks) {
+      ptr = allocator.allocate(5);
+    }
+    const std::size_t blocks = allocator.blocks_.size();
+
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < 4; ++i) {
+      consumers.emplace_back([&, i]() {
+        for (std::size_t j = i; j < slots.size(); j += 4) {
+          allocator.deallocate(slots[j], 1);
+        }
+        for (std::size_t j = i; j < chunks.size(); j += 4) {
+          allocator.deallocate(chunks[j], 5);
+        }
+      });
+    }
+    for (auto &consumer : consumers) {
+      consumer.join();
+    }
+
+    // Everything freed remotely is handed out again before any new block
+    std::vector<double *> reused(slots.size());
+    for (auto &ptr : reused) {
+      ptr = allocator.allocate(1);
+    }
+    for (auto &ptr : chunks) {
+      ptr = allocator.allocate(5);
+    }
+    assert(allocator.blocks_.size() == blocks);
+
+    for (auto ptr : reused) {
+      allocator.deallocate(ptr, 1);
+    }
+    for (auto ptr : chunks) {
+      allocator.deallocate(ptr, 5);
+    }
+  }
+
+  // Frees from other threads are folded back before trimming: the blocks
+  // they emptied are released as well
+  std::vector<double *> slots(1 << 10);
+  for (auto &ptr : slots) {
+    ptr = allocator.allocate(1);
+  }
+  double *chunk = allocator.allocate(5);
+  std::thread consumer([&]() {
+    for (auto ptr : slots) {
+      allocator.deallocate(ptr, 1);
+    }
+    allocator.deallocate(chunk, 5);
+  });
+  consumer.join();
+  allocator.trim();
+  assert(allocator.blocks_.empty());
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+//
+//  unit_test_threadCache.cpp
+//  memorypool
+//
+
+#include "../threadCache.hpp"
+
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace _fmmAllocator;
+
+int main() {
+  ThreadCachedAllocator<double, 4 * detail::KiB> allocator;
+
+  // Slots allocated by one thread and freed by another end up in the other
+  // thread's magazine (and from there back in the central pool)
+  std::vector<double *> ptrs(1 << 12);
+  std::thread producer([&]() {
+    for (auto &ptr : ptrs) {
+      ptr = allocator.allocate(1);
+      *ptr = 1.;
+    }
+  });
+  producer.join();
+
+  std::vector<std::thread> consumers;
+  for (std::size_t i = 0; i < 4; ++i) {
+    consumers.emplace_back([&, i]() {
+      for (std::size_t j = i; j < ptrs.size(); j += 4) {
+        assert(*ptrs[j] == 1.);
+        allocator.deallocate(ptrs[j], 1);
+      }
+      double *chunk = allocator.allocate(8);
+      allocator.deallocate(chunk, 8);
+    });
+  }
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+
+  // A pool goes away with its last handle, even if a thread that cached some
+  // of its slots is still running
+  using Allocator = ThreadCachedAllocator<double, 4 * detail::KiB>;
+  std::mutex mutex;
+  std::condition_variable cv;
+  int stage = 0;
+  std::unique_ptr<Allocator> other(new Allocator());
+  std::thread worker([&]() {
+    other->deallocate(other->allocate(1), 1);
+    std::unique_lock<std::mutex> lock{mutex};
+    stage = 1;
+    cv.notify_all();
+    cv.wait(lock, [&]() { return stage == 2; });
+
+    // A new pool may take the index of the one gone, never its magazine
+    Allocator next;
+    next.deallocate(next.allocate(1), 1);
+  });
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    cv.wait(lock, [&]() { return stage == 1; });
+    other.reset();
+    stage = 2;
+    cv.notify_all();
+  }
+  worker.join();
+
+  // The indices of the pools gone are reused: the registries stay small
+  for (std::size_t i = 0; i < 1000; ++i) {
+    Allocator temporary;
+    temporary.deallocate(temporary.allocate(1), 1);
+  }
+  assert(detail::local_magazines().size() <= 3);
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+//
+//  unit_test_threadPool.cpp
+//  memorypool
+//
+
+#include "../threadPool.hpp"
+
+#include <cassert>
+
+/// Fork/join: every call forks two tasks and helps until both are done
+long fib(ThreadPool &pool, long n) {
+  if (n < 2) {
+    return n;
+  }
+  long a = 0, b = 0;
+  std::atomic<int> done{0};
+  pool.submit([&]() {
+    a = fib(pool, n - 1);
+    done.fetch_add(1, std::memory_order_release);
+  });
+  pool.submit([&]() {
+    b = fib(pool, n - 2);
+    done.fetch_add(1, std::memory_order_release);
+  });
+  pool.run_until([&]() { return done.load(std::memory_order_acquire) == 2; });
+  return a + b;
+}
+
+int main() {
+  // Work-stealing deque: owner pops LIFO, thieves steal FIFO, and it grows
+  WorkStealingDeque<int *> deque(2);
+  int values[8];
+  for (auto &value : values) {
+    deque.push(&value);
+  }
+  int *value = nullptr;
+  assert(deque.steal(value) && value == &values[0]);
+  assert(deque.pop(value) && value == &values[7]);
+  assert(deque.size_approx() == 6);
+
+  ThreadPool pool(4);
+  assert(fib(pool, 18) == 2584);
+
+  // Tasks submitted from outside the pool, with a large capture
+  std::atomic<long> sum{0};
+  for (long i = 0; i < 1000; ++i) {
+    long padding[16] = {i};
+    pool.submit([&sum, padding]() { sum += padding[0]; });
+  }
+  pool.wait();
+  assert(sum == 999 * 1000 / 2);
+
+  return 0;
+}
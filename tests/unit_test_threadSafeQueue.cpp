@@ -7,10 +7,55 @@
 
 #include "../threadSafeQueue.hpp"
 
+#include <cassert>
+#include <thread>
+#include <vector>
+
 int main()
 {
 	ThreadSafeQueue<double> queue;
 	
 	queue.emplace_back(34);
+	assert(queue.size() == 1);
+	assert(queue.pop_front() == 34);
+
+	// Non-blocking and timed pops on an empty queue
+	double value;
+	assert(!queue.try_pop(value));
+	assert(!queue.pop_for(value, std::chrono::milliseconds(1)));
+
+	// try_pop assigns: noexcept only if assigning cannot throw either
+	struct Assigned {
+		Assigned() = default;
+		Assigned(Assigned &&) noexcept = default;
+		Assigned &operator=(Assigned &&) { return *this; }
+	};
+	ThreadSafeQueue<Assigned> assigned;
+	Assigned element;
+	static_assert(noexcept(queue.try_pop(value)), "");
+	static_assert(!noexcept(assigned.try_pop(element)), "");
+
+	// Bulk push and drain
+	std::vector<double> in{1, 2, 3, 4, 5};
+	queue.push_range(in.begin(), in.end());
+	std::vector<double> out;
+	assert(queue.drain_into(std::back_inserter(out), 3) == 3);
+	assert(queue.pop_back() == 5);
+	assert(queue.try_pop(value) && value == 4);
+	assert((out == std::vector<double>{1, 2, 3}));
+
+	// A waiting consumer is woken by a bulk push
+	std::thread consumer([&]() {
+		double sum = 0;
+		for (int i = 0; i < 5; ++i)
+			sum += queue.pop_front();
+		assert(sum == 15);
+	});
+	queue.push_range(in.begin(), in.end());
+	consumer.join();
+
+	queue.emplace_back(1);
+	queue.clear();
+	assert(queue.empty());
 	return 0;
 }
@@ -0,0 +1,338 @@
+/** @file threadCache.hpp
+ *  @brief Thread-local allocation caches in front of a shared PoolAllocator
+ *
+ *  Each thread keeps a bounded magazine of free single slots per pool, which
+ *  is refilled from and flushed to the central pool in batches
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef threadCache_hpp
+#define threadCache_hpp
+
+#include "generalAllocator.hpp"
+#include "poolAllocator.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace _fmmAllocator {
+
+namespace detail {
+
+/// @brief Hands out the index of a pool in the magazine registry of every
+/// thread, along with a generation unique for the life of the program. An
+/// index is reused once its pool is gone: the generation tells the magazines
+/// of the new pool from the ones of the old one
+class MagazineIds {
+public:
+  struct Id {
+    std::size_t index_;
+    std::size_t generation_;
+  };
+
+  static Id acquire() {
+    State &state = get_state();
+    std::lock_guard<std::mutex> lock{state.mutex_};
+    Id id{state.generations_.size(), ++state.generation_};
+    if (!state.free_.empty()) {
+      id.index_ = state.free_.back();
+      state.free_.pop_back();
+      state.generations_[id.index_] = id.generation_;
+    } else {
+      state.generations_.push_back(id.generation_);
+    }
+    return id;
+  }
+
+  static void release(const Id &id) {
+    State &state = get_state();
+    std::lock_guard<std::mutex> lock{state.mutex_};
+    state.generations_[id.index_] = 0;
+    state.free_.push_back(id.index_);
+  }
+
+  /// @brief Runs \ref fn if the pool \ref id still exists. It cannot go away
+  /// while \ref fn runs
+  template <typename _Fn> static void if_alive(const Id &id, _Fn &&fn) {
+    State &state = get_state();
+    std::lock_guard<std::mutex> lock{state.mutex_};
+    if (state.generations_[id.index_] == id.generation_) {
+      fn();
+    }
+  }
+
+private:
+  struct State {
+    std::mutex mutex_;
+    std::size_t generation_ = 0;
+    /// The generation of the pool at every index, zero if none
+    std::vector<std::size_t> generations_;
+    std::vector<std::size_t> free_;
+  };
+
+  /// NOTE: Never destroyed, as threads may exit after the static destructors
+  static State &get_state() {
+    static State *state = new State();
+    return *state;
+  }
+};
+
+/// @brief The magazine of a thread for the pool at its index in the registry
+struct LocalMagazine {
+  std::size_t generation_ = 0;
+  void *magazine_ = nullptr;
+  void *depot_ = nullptr;
+  void (*retire_)(void *depot, void *magazine) = nullptr;
+};
+
+/// @brief The magazines of a thread, handed back to their pools (the ones
+/// still alive) when it exits
+struct LocalMagazines {
+  ~LocalMagazines() {
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+      LocalMagazine &entry = entries_[i];
+      if (entry.magazine_ != nullptr) {
+        MagazineIds::if_alive({i, entry.generation_}, [&entry]() {
+          entry.retire_(entry.depot_, entry.magazine_);
+        });
+      }
+    }
+  }
+
+  std::vector<LocalMagazine> entries_;
+};
+
+/// @brief The magazines of the calling thread, indexed by pool
+inline std::vector<LocalMagazine> &local_magazines() {
+  static thread_local LocalMagazines registry;
+  return registry.entries_;
+}
+
+/// @brief The magazines of every thread that used a pool. A thread reaches its
+/// own through its registry, but the depot owns them: they go away with the
+/// pool, not with the threads. A thread that exits first hands its magazine
+/// back with \ref _Magazine::drain
+/// NOTE: The owner of the depot must \ref close it before anything else in
+/// its dtor, so that no thread hands a magazine back meanwhile
+template <typename _Magazine> class MagazineDepot {
+public:
+  MagazineDepot() : id_(MagazineIds::acquire()) {}
+
+  MagazineDepot(const MagazineDepot &) = delete;
+  MagazineDepot &operator=(const MagazineDepot &) = delete;
+
+  ~MagazineDepot() { close(); }
+
+  /// @brief The calling thread's magazine, made from \ref args on first use
+  template <typename... _Args>
+  DEQUE_INLINE _Magazine &local(_Args &&... args) {
+    std::vector<LocalMagazine> &registry = local_magazines();
+    if (likely(id_.index_ < registry.size() &&
+               registry[id_.index_].generation_ == id_.generation_)) {
+      return *static_cast<_Magazine *>(registry[id_.index_].magazine_);
+    }
+    return create(registry, std::forward<_Args>(args)...);
+  }
+
+  /// @brief Hands the calling thread's magazine back, if it has one
+  void retire_local() {
+    std::vector<LocalMagazine> &registry = local_magazines();
+    if (id_.index_ < registry.size() &&
+        registry[id_.index_].generation_ == id_.generation_) {
+      retire(static_cast<_Magazine *>(registry[id_.index_].magazine_));
+      registry[id_.index_] = LocalMagazine();
+    }
+  }
+
+  /// @brief From now on, threads that exit leave their magazines to the depot
+  void close() {
+    if (!closed_) {
+      MagazineIds::release(id_);
+      closed_ = true;
+    }
+  }
+
+private:
+  template <typename... _Args>
+  _Magazine &create(std::vector<LocalMagazine> &registry, _Args &&... args) {
+    _Magazine *const magazine = new _Magazine(std::forward<_Args>(args)...);
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      magazines_.emplace_back(magazine);
+    }
+    if (id_.index_ >= registry.size()) {
+      registry.resize(id_.index_ + 1);
+    }
+    registry[id_.index_] = {id_.generation_, magazine, this, &retire_magazine};
+    return *magazine;
+  }
+
+  void retire(_Magazine *magazine) {
+    magazine->drain();
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto it = std::find_if(
+        magazines_.begin(), magazines_.end(),
+        [magazine](const std::unique_ptr<_Magazine> &other) {
+          return other.get() == magazine;
+        });
+    std::swap(*it, magazines_.back());
+    magazines_.pop_back();
+  }
+
+  static void retire_magazine(void *depot, void *magazine) {
+    static_cast<MagazineDepot *>(depot)->retire(
+        static_cast<_Magazine *>(magazine));
+  }
+
+  MagazineIds::Id id_;
+  bool closed_ = false;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<_Magazine>> magazines_;
+};
+
+} // namespace detail
+
+/// @brief
+/// The ThreadCachedAllocator is a handle to a central \ref PoolAllocator shared
+/// by every thread. Single slot (de)allocations are served by a magazine owned
+/// by the calling thread and never take a lock; the magazine is refilled from
+/// (or flushed to) the central pool \ref _Magazine_Size / 2 slots at a time.
+/// Any other allocation goes straight to the central pool under its mutex.
+///
+/// NOTE: Copies share the central pool. The central pool, and the slots cached
+/// by every thread, are released along with the last handle
+template <typename _Tp, std::size_t _Block_Size, bool _Recycle_Slots = false,
+          std::size_t _Magazine_Size = 64>
+class ThreadCachedAllocator : public GeneralAllocator<_Tp> {
+public:
+  using value_type = _Tp;
+  using reference = _Tp &;
+  using const_reference = const _Tp &;
+  using pointer = _Tp *;
+  using const_pointer = const _Tp *;
+
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+  typedef std::false_type is_always_equal;
+
+  using pool_allocator = PoolAllocator<_Tp, _Block_Size, _Recycle_Slots>;
+
+  template <typename _Up> struct rebind {
+    typedef ThreadCachedAllocator<_Up, _Block_Size, _Recycle_Slots,
+                                  _Magazine_Size>
+        other;
+  };
+
+private:
+  struct Magazine;
+
+  /// @brief The shared pool and the lock serializing access to it
+  struct Central {
+    std::mutex mutex_;
+    pool_allocator pool_;
+
+    /// NOTE: Goes first, along with the slots cached by every thread
+    detail::MagazineDepot<Magazine> magazines_;
+  };
+
+  /// @brief A bounded stack of free single slots owned by one thread
+  struct Magazine {
+    explicit Magazine(Central &__central) : central_(&__central) {}
+
+    /// Returns every cached slot to the central pool
+    void drain() { flush(size_); }
+
+    /// Returns the \ref count most recently cached slots to the central pool
+    void flush(std::size_t count) {
+      std::lock_guard<std::mutex> lock{central_->mutex_};
+      for (; count > 0; --count) {
+        central_->pool_.deallocate(slots_[--size_], 1);
+      }
+    }
+
+    /// Takes \ref count slots from the central pool
+    void refill(std::size_t count) {
+      std::lock_guard<std::mutex> lock{central_->mutex_};
+      for (; count > 0; --count) {
+        slots_[size_++] = central_->pool_.allocate(1);
+      }
+    }
+
+    Central *central_;
+    std::size_t size_ = 0;
+    pointer slots_[_Magazine_Size];
+  };
+
+public:
+  /// @brief Default ctor: creates a new central pool
+  explicit ThreadCachedAllocator() : central_(std::make_shared<Central>()) {
+    DEQUE_PRINT("CACHE: Standard Allocator called for\t\t"
+                << typeid(_Tp).name())
+  }
+
+  // NOTE: A rebound handle would need its own central pool
+  template <typename _Up>
+  explicit ThreadCachedAllocator(
+      const ThreadCachedAllocator<_Up, _Block_Size, _Recycle_Slots,
+                                  _Magazine_Size> &) = delete;
+
+  /// @brief Allocates memory
+  pointer allocate(std::size_t count, void * = nullptr) {
+    if (likely(count == 1)) {
+      Magazine &magazine = local_magazine();
+      if (unlikely(magazine.size_ == 0)) {
+        magazine.refill(_Magazine_Size / 2);
+      }
+      return magazine.slots_[--magazine.size_];
+    }
+
+    std::lock_guard<std::mutex> lock{central_->mutex_};
+    return central_->pool_.allocate(count);
+  }
+
+  /// @brief Deallocates memory
+  void deallocate(pointer ptr, std::size_t count) {
+    if (likely(count == 1)) {
+      Magazine &magazine = local_magazine();
+      if (unlikely(magazine.size_ == _Magazine_Size)) {
+        magazine.flush(_Magazine_Size / 2);
+      }
+      magazine.slots_[magazine.size_++] = ptr;
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock{central_->mutex_};
+    central_->pool_.deallocate(ptr, count);
+  }
+
+  /// @brief Returns the calling thread's cached slots to the central pool
+  void flush() { central_->magazines_.retire_local(); }
+
+  bool operator==(const ThreadCachedAllocator &__other) const {
+    return central_ == __other.central_;
+  }
+
+  bool operator!=(const ThreadCachedAllocator &__other) const {
+    return central_ != __other.central_;
+  }
+
+private:
+  /// @brief The calling thread's magazine of this pool (created on first use)
+  DEQUE_INLINE Magazine &local_magazine() {
+    return central_->magazines_.local(*central_);
+  }
+
+  std::shared_ptr<Central> central_;
+};
+
+} // namespace _fmmAllocator
+#endif /* threadCache_hpp */
@@ -0,0 +1,262 @@
+/** @file threadPool.hpp
+ *  @brief Work-stealing thread pool
+ *
+ *  One work-stealing deque per worker, task nodes drawn from per-worker pool
+ *  allocators
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef threadPool_h
+#define threadPool_h
+
+#include "poolAllocator.hpp"
+#include "threadSafeQueue.hpp"
+#include "workStealingDeque.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief A fork/join friendly thread pool
+/// A task submitted by a worker is pushed on that worker's deque and its node
+/// comes from that worker's PoolAllocator; idle workers steal from the others.
+/// The thread running a task frees its node, which is a remote free when the
+/// task was stolen. Tasks submitted from outside the pool go through a shared
+/// injection queue.
+class ThreadPool {
+  /// @brief A type-erased callable stored in a fixed size node
+  struct Task;
+
+  using task_allocator = _fmmAllocator::PoolAllocator<Task, 64 * 1024>;
+
+  struct Task {
+    /// Callables up to this size are stored in the node itself
+    static constexpr std::size_t storage_size = 48;
+
+    void (*run_)(Task *);
+    void (*destroy_)(Task *);
+
+    /// The pool of the node (nullptr if it came from the heap)
+    task_allocator *allocator_;
+
+    typename std::aligned_storage<storage_size,
+                                  alignof(std::max_align_t)>::type storage_;
+  };
+
+  /// @brief The state owned by one worker thread
+  struct Worker {
+    explicit Worker(ThreadPool *__pool) : pool_(__pool) {}
+
+    ThreadPool *const pool_;
+    WorkStealingDeque<Task *> tasks_;
+    task_allocator allocator_;
+  };
+
+public:
+  explicit ThreadPool(
+      std::size_t n_threads = std::thread::hardware_concurrency()) {
+    n_threads = n_threads > 0 ? n_threads : 1;
+    for (std::size_t i = 0; i < n_threads; ++i) {
+      workers_.emplace_back(new Worker(this));
+    }
+    for (std::size_t i = 0; i < n_threads; ++i) {
+      threads_.emplace_back([this, i]() { work(*workers_[i], i); });
+    }
+  }
+
+  /// @brief Runs every pending task, then stops the workers
+  ~ThreadPool() {
+    wait();
+    stop_.store(true, std::memory_order_release);
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// @brief Schedules \ref func
+  template <typename _Function> void submit(_Function &&func) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    Worker *worker = local_worker_of_this();
+    if (worker != nullptr) {
+      worker->tasks_.push(make_task(&worker->allocator_,
+                                    std::forward<_Function>(func)));
+    } else {
+      injected_.push_back(make_task(nullptr, std::forward<_Function>(func)));
+      n_injected_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  /// @brief Runs pending tasks until \ref done returns true (the join of a
+  /// fork/join: the caller helps instead of blocking)
+  template <typename _Predicate> void run_until(_Predicate &&done) {
+    Worker *worker = local_worker_of_this();
+    const std::size_t first = worker != nullptr ? index_of(worker) : 0;
+    for (std::size_t idle = 0; !done();) {
+      if (Task *task = find_task(worker, first)) {
+        run(task);
+        idle = 0;
+      } else {
+        backoff(idle++);
+      }
+    }
+  }
+
+  /// @brief Runs pending tasks until every submitted task completed
+  void wait() {
+    run_until([this]() {
+      return pending_.load(std::memory_order_acquire) == 0;
+    });
+  }
+
+  std::size_t size() const { return workers_.size(); }
+
+private:
+  /// @brief The worker loop: own deque first, then the others
+  void work(Worker &worker, std::size_t index) {
+    // The task nodes of this worker are allocated on this thread only
+    worker.allocator_.set_owner(std::this_thread::get_id());
+    local_worker() = &worker;
+
+    for (std::size_t idle = 0; !stop_.load(std::memory_order_acquire);) {
+      if (Task *task = find_task(&worker, index)) {
+        run(task);
+        idle = 0;
+      } else {
+        backoff(idle++);
+      }
+    }
+    local_worker() = nullptr;
+  }
+
+  /// @brief Own deque, then the injection queue, then steals from the others
+  Task *find_task(Worker *worker, std::size_t first) {
+    Task *task = nullptr;
+    if (worker != nullptr && worker->tasks_.pop(task)) {
+      return task;
+    }
+    if (n_injected_.load(std::memory_order_acquire) > 0 &&
+        injected_.try_pop(task)) {
+      n_injected_.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+    const std::size_t n_workers = workers_.size();
+    for (std::size_t i = 1; i <= n_workers; ++i) {
+      Worker &victim = *workers_[(first + i) % n_workers];
+      if (&victim != worker && victim.tasks_.steal(task)) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  void run(Task *task) {
+    task->run_(task);
+    release(task);
+    pending_.fetch_sub(1, std::memory_order_release);
+  }
+
+  /// @brief Builds a task node around \ref func
+  template <typename _Function>
+  static Task *make_task(task_allocator *allocator, _Function &&func) {
+    using function_type = typename std::decay<_Function>::type;
+    constexpr bool in_place =
+        sizeof(function_type) <= Task::storage_size &&
+        alignof(function_type) <= alignof(std::max_align_t);
+
+    Task *task = allocator != nullptr ? allocator->allocate(1) : new Task;
+    task->allocator_ = allocator;
+    store<function_type>(task, std::forward<_Function>(func),
+                         std::integral_constant<bool, in_place>());
+    return task;
+  }
+
+  /// @brief Small callables live in the node
+  template <typename _Function, typename _Arg>
+  static void store(Task *task, _Arg &&func, std::true_type) {
+    new (&task->storage_) _Function(std::forward<_Arg>(func));
+    task->run_ = [](Task *t) {
+      (*reinterpret_cast<_Function *>(&t->storage_))();
+    };
+    task->destroy_ = [](Task *t) {
+      reinterpret_cast<_Function *>(&t->storage_)->~_Function();
+    };
+  }
+
+  /// @brief Large callables live on the heap
+  template <typename _Function, typename _Arg>
+  static void store(Task *task, _Arg &&func, std::false_type) {
+    new (&task->storage_) _Function *(new _Function(std::forward<_Arg>(func)));
+    task->run_ = [](Task *t) {
+      (**reinterpret_cast<_Function **>(&t->storage_))();
+    };
+    task->destroy_ = [](Task *t) {
+      delete *reinterpret_cast<_Function **>(&t->storage_);
+    };
+  }
+
+  /// @brief Returns the node to the pool it came from
+  static void release(Task *task) {
+    task->destroy_(task);
+    if (task->allocator_ != nullptr) {
+      task->allocator_->deallocate(task, 1);
+    } else {
+      delete task;
+    }
+  }
+
+  /// @brief The worker run by the calling thread, if it belongs to this pool
+  Worker *local_worker_of_this() {
+    Worker *worker = local_worker();
+    return worker != nullptr && worker->pool_ == this ? worker : nullptr;
+  }
+
+  static Worker *&local_worker() {
+    static thread_local Worker *worker = nullptr;
+    return worker;
+  }
+
+  std::size_t index_of(Worker *worker) const {
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      if (workers_[i].get() == worker) {
+        return i;
+      }
+    }
+    return 0;
+  }
+
+  static void backoff(std::size_t idle) {
+    if (idle < 64) {
+      return;
+    } else if (idle < 1024) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  /// Tasks submitted from outside the pool
+  ThreadSafeQueue<Task *> injected_;
+  std::atomic<std::size_t> n_injected_{0};
+
+  /// Submitted tasks that did not complete yet
+  std::atomic<std::size_t> pending_{0};
+
+  std::atomic<bool> stop_{false};
+};
+
+#endif /* threadPool_h */
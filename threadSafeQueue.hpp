@@ -8,13 +8,21 @@
 #ifndef threadSafeQueue_h
 #define threadSafeQueue_h
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <type_traits>
 
 /// @brief A simple thread-safe wrapping on std::deque
 /// Check http://en.cppreference.com/w/cpp/container/deque for function details
+///
+/// NOTE: The pops are noexcept when moving the element cannot throw: locking
+/// the mutex then is assumed not to fail either, a std::system_error from it
+/// terminates
 template <typename _Tp, typename _Allocator = std::allocator<_Tp>>
 class ThreadSafeQueue {
   typedef _Tp value_type;
@@ -33,27 +41,82 @@ public:
   ThreadSafeQueue &
   operator=(const ThreadSafeQueue<__Tp, __Allocator> &) = delete;
 
-  void clear();
+  void clear() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    container_.clear();
+  }
+
+  /// NOTE: Only a snapshot, other threads may change it right away
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return container_.size();
+  }
 
-  /// TODO: Not thread-safe
-  std::size_t size() { return container_.size(); }
+  bool empty() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return container_.empty();
+  }
 
-  void pop_front() noexcept {
+  /// @brief Waits for an element and returns the front one
+  value_type pop_front() noexcept(nothrow_move) {
     std::unique_lock<std::mutex> lock{mutex_};
 
     while (container_.empty())
       data_notification_.wait(lock);
 
-    container_.pop_front();
+    return take_front();
   }
 
-  void pop_back() noexcept {
+  /// @brief Waits for an element and returns the back one
+  value_type pop_back() noexcept(nothrow_move) {
     std::unique_lock<std::mutex> lock{mutex_};
 
     while (container_.empty())
       data_notification_.wait(lock);
 
+    value_type value = std::move(container_.back());
     container_.pop_back();
+    return value;
+  }
+
+  /// @brief Moves the front element into \ref value if there is one
+  bool try_pop(value_type &value) noexcept(nothrow_move &&
+                                           nothrow_move_assign) {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    if (container_.empty())
+      return false;
+
+    value = take_front();
+    return true;
+  }
+
+  /// @brief Waits at most \ref timeout for an element and moves the front one
+  /// into \ref value. Returns false on timeout
+  template <class Rep, class Period>
+  bool pop_for(value_type &value,
+               const std::chrono::duration<Rep, Period> &timeout) {
+    std::unique_lock<std::mutex> lock{mutex_};
+
+    if (!data_notification_.wait_for(lock, timeout,
+                                     [&]() { return !container_.empty(); }))
+      return false;
+
+    value = take_front();
+    return true;
+  }
+
+  /// @brief Moves up to \ref max front elements to \ref out under a single
+  /// lock acquisition (without waiting). Returns the number of elements moved
+  template <class OutputIt>
+  std::size_t drain_into(OutputIt out, std::size_t max = std::size_t(-1)) {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    const std::size_t count = std::min(max, container_.size());
+    const auto last = container_.begin() + count;
+    std::move(container_.begin(), last, out);
+    container_.erase(container_.begin(), last);
+    return count;
   }
 
   template <class... Args> void emplace_front(Args &&... args) {
@@ -76,7 +139,27 @@ public:
         [&]() { container_.push_back(std::forward<value_type>(value)); });
   }
 
+  /// @brief Appends [first, last) under a single lock acquisition and wakes
+  /// the waiting consumers with a single notification
+  template <class InputIt> void push_range(InputIt first, InputIt last) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    const std::size_t before = container_.size();
+    container_.insert(container_.end(), first, last);
+    const std::size_t added = container_.size() - before;
+    lock.unlock();
+
+    if (added == 1)
+      data_notification_.notify_one();
+    else if (added > 1)
+      data_notification_.notify_all();
+  }
+
 private:
+  static constexpr bool nothrow_move =
+      std::is_nothrow_move_constructible<value_type>::value;
+  static constexpr bool nothrow_move_assign =
+      std::is_nothrow_move_assignable<value_type>::value;
+
   template <typename _Lambda> void add_with_notification(_Lambda &&func) {
     std::unique_lock<std::mutex> lock{mutex_};
     func();
@@ -84,9 +167,16 @@ private:
     data_notification_.notify_one();
   }
 
+  /// NOTE: Requires the lock and a non-empty container
+  value_type take_front() {
+    value_type value = std::move(container_.front());
+    container_.pop_front();
+    return value;
+  }
+
   // Wrap around the STL non-thread-safe deque
   std::deque<value_type, allocator_type> container_;
-  std::mutex mutex_;
+  mutable std::mutex mutex_;
   std::condition_variable data_notification_;
 };
 
@@ -10,8 +10,10 @@
 #ifndef util_hpp
 #define util_hpp
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -28,6 +30,30 @@
 #define DEQUE_PRINT(x)
 #endif
 
+// Per pool counters, see PoolAllocator::stats (nothing is counted otherwise)
+#ifdef POOL_STATS_ENABLED
+#define POOL_STAT(x) x;
+#else
+#define POOL_STAT(x)
+#endif
+
+// Allocation traces, see PoolAllocator::start_trace
+#ifdef POOL_TRACE_ENABLED
+#define POOL_TRACE(x) x;
+#else
+#define POOL_TRACE(x)
+#endif
+
+// Instrumentation hook: POOL_EVENT(name, n) reports \ref n occurrences of a
+// slow path of the pools, where name is one of new_block (a block taken from
+// the block source or faulted back in), release_block, large_map,
+// large_unmap, scan (a free chunk visited by the first-fit scan),
+// remote_drain and recycle. Define it before including the pools to observe
+// them (see benchmarks/bench_latency.cpp)
+#ifndef POOL_EVENT
+#define POOL_EVENT(name, n)
+#endif
+
 #ifdef DEQUE_EXCEPTIONS_ENABLED
 #define DEQUE_TRY try
 #define DEQUE_CATCH(...) catch (__VA_ARGS__)
@@ -59,25 +85,102 @@ enum BlockSizes : std::size_t {
   GiB = MiB * KiB,
 };
 
-/// Each memory chunk is organized as follows:
-///		|	--------	--------	--------	--------
-/// 	|	STL_ptrs	size_data	  data0		  ...
+/// @brief Assumed size of a cache line (see PoolAllocator's _Slot_Align)
+constexpr std::size_t cache_line = 64;
+
+/// @brief Floor of the base 2 logarithm (log2_floor(0) is defined as 0)
+constexpr std::size_t log2_floor(std::size_t __n) {
+#if __GNUC__ || __INTEL_COMPILER
+  return __n > 1 ? 63 - static_cast<std::size_t>(__builtin_clzll(__n)) : 0;
+#else
+  return __n > 1 ? 1 + log2_floor(__n >> 1) : 0;
+#endif
+}
+
+/// @brief Index of the least significant set bit (__n must not be 0)
+inline std::size_t count_trailing_zeros(std::size_t __n) {
+  DEQUE_ASSERT(__n != 0);
+#if __GNUC__ || __INTEL_COMPILER
+  return static_cast<std::size_t>(__builtin_ctzll(__n));
+#else
+  std::size_t count = 0;
+  while (!(__n & 1)) {
+    __n >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+/// @brief Number of set bits of \ref __n
+inline std::size_t popcount(std::uint64_t __n) {
+#if __GNUC__ || __INTEL_COMPILER
+  return static_cast<std::size_t>(__builtin_popcountll(__n));
+#else
+  std::size_t count = 0;
+  for (; __n != 0; __n &= __n - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+/// @brief Number of power-of-two size classes needed to bin every chunk that
+/// fits in a block of __block_size bytes
+constexpr std::size_t size_classes(std::size_t __block_size) {
+  return log2_floor(__block_size) + 1;
+}
+
+/// @brief One bit per slot of a block, telling whether the slot is the first
+/// or the last one of a free chunk (the boundary tags of the chunk)
+template <std::size_t _Slots> class BoundaryTags {
+public:
+  DEQUE_INLINE bool test(std::size_t __i) const {
+    return (words_[__i / digits] >> (__i % digits)) & 1;
+  }
+
+  DEQUE_INLINE void set(std::size_t __i) {
+    words_[__i / digits] |= std::uint64_t(1) << (__i % digits);
+  }
+
+  DEQUE_INLINE void reset(std::size_t __i) {
+    words_[__i / digits] &= ~(std::uint64_t(1) << (__i % digits));
+  }
+
+private:
+  static constexpr std::size_t digits = 64;
+
+  std::uint64_t words_[(_Slots + digits - 1) / digits] = {};
+};
+
+/// @brief No tags: nothing is coalesced
+template <> class BoundaryTags<0> {
+public:
+  DEQUE_INLINE bool test(std::size_t) const { return false; }
+  DEQUE_INLINE void set(std::size_t) {}
+  DEQUE_INLINE void reset(std::size_t) {}
+};
+
+/// Each free memory chunk is organized as follows:
+///		|	--------	--------	--------	--------	...	--------
+/// 	|	  prev		  next		  size		  data0		...	 footer
+///
+/// The header (the free list links and the size) takes padding() slots and is
+/// not counted in the size. The footer is the last data slot: when coalescing,
+/// it repeats the size so that the chunk can be found from its right neighbour
+///
+/// Slots are aligned to __Tp, to a pointer and to __Slot_Align, whichever is
+/// the strictest: every chunk (and every allocation carved from one) starts
+/// and ends on that boundary
 ///
 /// This is where the nasty pointer arithmetic is made
-template <typename __Tp> class MemoryChunk {
+template <typename __Tp, std::size_t __Slot_Align = 1> class MemoryChunk {
 public:
   using value_type = __Tp;
-  using memory_chunk = MemoryChunk<__Tp>;
+  using memory_chunk = MemoryChunk<__Tp, __Slot_Align>;
 
   /// @brief Default ctor
-  explicit MemoryChunk(void *__ptr, std::size_t __count) {
-    DEQUE_ASSERT(static_cast<void *>(static_cast<char *>(__ptr) +
-                                     pointers_in_chunk() * alignement()) ==
-                 address(*this));
-
-    // Save the size of the MemoryChunk (count * alignment = bytes)
-    new (address(*this)) std::size_t(__count);
-  }
+  explicit MemoryChunk(std::size_t __count) : size_(__count) {}
 
   /// @brief Gets a pointer for a new chunk from a bigger chunk (which becomes
   /// smaller)
@@ -109,7 +212,7 @@ public:
 
   /// @brief Returns a pointer of the size of the memory chunk
   DEQUE_INLINE static std::size_t *size_ptr(memory_chunk &__chunk) {
-    return static_cast<std::size_t *>(address_size(__chunk));
+    return std::addressof(__chunk.size_);
   }
 
   /// @brief Returns the size of the memory chunk
@@ -117,9 +220,18 @@ public:
     return *size_ptr(__chunk);
   }
 
-  /// @brief Returns the location of the size in a a memory chunk
-  DEQUE_INLINE static void *address_size(memory_chunk &__chunk) {
-    return address(__chunk);
+  /// @brief Returns the location of the footer (the last data slot)
+  DEQUE_INLINE static std::size_t *footer_ptr(memory_chunk &__chunk) {
+    return static_cast<std::size_t *>(
+        address_at(__chunk, size(__chunk) - 1));
+  }
+
+  /// @brief Returns the chunk whose footer is at \ref __footer
+  DEQUE_INLINE static memory_chunk *from_footer(void *__footer) {
+    const std::size_t count = *static_cast<std::size_t *>(__footer);
+    return reinterpret_cast<memory_chunk *>(
+        static_cast<char *>(__footer) -
+        (count - 1 + padding()) * alignement());
   }
 
   /// @brief Returns the location
@@ -127,7 +239,7 @@ public:
                                        std::size_t count) {
     void *temp = address(__chunk);
     return static_cast<void *>(static_cast<char *>(temp) +
-                               (count + 1) * alignement());
+                               (count + padding()) * alignement());
   }
 
   /// @brief Returns the address after the memory chunk
@@ -135,34 +247,56 @@ public:
     return address_at(__chunk, size(__chunk));
   }
 
+  /// @brief Free list links
+  DEQUE_INLINE static memory_chunk *&prev(memory_chunk &__chunk) {
+    return __chunk.prev_;
+  }
+
+  DEQUE_INLINE static memory_chunk *&next(memory_chunk &__chunk) {
+    return __chunk.next_;
+  }
+
   // This number depends if it's a forward (1) or double linked list (2)
   DEQUE_INLINE static constexpr std::size_t pointers_in_chunk() { return 2; }
 
-  // The padding before data is due to the list pointers and chunk size
+  // The padding before data is due to the list pointers and chunk size, in
+  // whole slots (a single one once slots are 32 bytes or more)
   DEQUE_INLINE static constexpr std::size_t padding() {
-    return pointers_in_chunk() + 1;
+    constexpr std::size_t bytes = (pointers_in_chunk() + 1) * sizeof(void *);
+    return (bytes + alignement() - 1) / alignement();
   }
 
   DEQUE_INLINE static constexpr std::size_t alignement() {
     return alignof(Slot);
   }
 
+  /// @brief Number of slots (of alignement() bytes) spanned by __count
+  /// elements
+  DEQUE_INLINE static constexpr std::size_t units(std::size_t __count) {
+    return (__count * sizeof(value_type) + alignement() - 1) / alignement();
+  }
+
   DEQUE_INLINE static auto address(memory_chunk &__chunk) {
     return std::addressof(__chunk);
   }
 
   // Memory slot (either a pointer or value_type)
-  union Slot {
+  // NOTE: alignas may not weaken the alignment of any member
+  union alignas(std::max({__Slot_Align, alignof(value_type),
+                          alignof(std::size_t), alignof(void *)})) Slot {
     value_type data;
     std::size_t size;
     Slot *ptr;
   };
+
+private:
+  memory_chunk *prev_ = nullptr;
+  memory_chunk *next_ = nullptr;
+  std::size_t size_;
 };
 
 } // namespace detail
 
-template <typename _Tp, class __Pool_Allocator> class ListAllocator;
-
 } // namespace _fmmAllocator
 
 #endif /* util_hpp */
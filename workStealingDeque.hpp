@@ -0,0 +1,156 @@
+/** @file workStealingDeque.hpp
+ *  @brief Chase-Lev work-stealing deque
+ *
+ *  The owner thread pushes and pops at the bottom, thieves steal from the top
+ *  (after Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient
+ *  Work-Stealing for Weak Memory Models")
+ *
+ *  @author Francisco Meirinhos
+ *  @bug Not yet found, but still underdeveloped
+ */
+
+#ifndef workStealingDeque_h
+#define workStealingDeque_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// @brief A growable, lock-free, single owner, multiple thieves deque
+/// Only the owner may call \ref push and \ref pop, any thread may \ref steal.
+/// The circular buffer doubles when full; the outgrown buffers are kept until
+/// destruction since a thief may still be reading them.
+template <typename _Tp> class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable<_Tp>::value,
+                "Elements are copied racily: use pointers or handles");
+
+public:
+  typedef _Tp value_type;
+
+  explicit WorkStealingDeque(std::size_t capacity = 256)
+      : array_(new Array(round_up(capacity))) {
+    arrays_.emplace_back(array_.load(std::memory_order_relaxed));
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  /// @brief Pushes at the bottom (owner only)
+  void push(value_type value) {
+    const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t top = top_.load(std::memory_order_acquire);
+    Array *array = array_.load(std::memory_order_relaxed);
+
+    if (bottom - top > static_cast<std::int64_t>(array->mask_)) {
+      array = grow(array, top, bottom);
+    }
+    array->put(bottom, value);
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  /// @brief Pops from the bottom (owner only). Returns false if empty
+  bool pop(value_type &value) {
+    const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = top_.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      // empty
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    value = array->get(bottom);
+    if (top == bottom) {
+      // last element: race the thieves for it
+      const bool won = top_.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  /// @brief Steals from the top (any thread). Returns false if empty or if
+  /// another thread won the race for the element
+  bool steal(value_type &value) {
+    std::int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+      return false;
+    }
+
+    Array *array = array_.load(std::memory_order_acquire);
+    value = array->get(top);
+    return top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+  /// NOTE: Only a snapshot, other threads may change it right away
+  std::size_t size_approx() const {
+    const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+  }
+
+  bool empty() const { return size_approx() == 0; }
+
+private:
+  /// @brief Circular buffer of atomic cells
+  struct Array {
+    explicit Array(std::size_t capacity)
+        : mask_(capacity - 1), cells_(new std::atomic<value_type>[capacity]) {}
+
+    value_type get(std::int64_t index) const {
+      return cells_[static_cast<std::size_t>(index) & mask_].load(
+          std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t index, value_type value) {
+      cells_[static_cast<std::size_t>(index) & mask_].store(
+          value, std::memory_order_relaxed);
+    }
+
+    const std::size_t mask_;
+    const std::unique_ptr<std::atomic<value_type>[]> cells_;
+  };
+
+  /// @brief Doubles the buffer (owner only)
+  Array *grow(Array *array, std::int64_t top, std::int64_t bottom) {
+    Array *bigger = new Array(2 * (array->mask_ + 1));
+    arrays_.emplace_back(bigger);
+    for (std::int64_t i = top; i < bottom; ++i) {
+      bigger->put(i, array->get(i));
+    }
+    array_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  static std::size_t round_up(std::size_t capacity) {
+    std::size_t power = 2;
+    while (power < capacity) {
+      power <<= 1;
+    }
+    return power;
+  }
+
+  /// Assumed size of a cache line (keeps the owner and thieves apart)
+  static constexpr std::size_t cache_line = 64;
+
+  alignas(cache_line) std::atomic<std::int64_t> top_{0};
+  alignas(cache_line) std::atomic<std::int64_t> bottom_{0};
+  alignas(cache_line) std::atomic<Array *> array_;
+
+  /// Every buffer ever used (owner only)
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+#endif /* workStealingDeque_h */